@@ -2,6 +2,7 @@
 #define APPROXIMATE_COMMUNITY_DETECTION_H
 
 #include "src/graph.h"
+#include "src/edge_stream.h"
 #include "utils/quality_measures.h"
 #include <random>
 #include <unordered_set>
@@ -15,7 +16,7 @@ class ApproximateCommunityDetection {
     private:
         unordered_map<int, Community> communities;
         int communityCount;
-        int totalEdges;
+        long long totalEdges;
         mt19937 gen;
         int stopBefore;
 
@@ -32,11 +33,14 @@ class ApproximateCommunityDetection {
         void updateKCommunityInformation(Node* node_moved, Community* main_community,
             Community* other_community, unordered_set<int>& frozen_node_ids);
         bool allCommunitiesSameSize();
+        // Keeps the stream of the edge list constructor alive for the delegated call
+        ApproximateCommunityDetection(const Graph& graph, int communityCount, EdgeStream&& events, int stopBefore, ofstream* outfile, NodeOrder nodeOrder);
 
     public:
         Graph acd_graph;
 
-        ApproximateCommunityDetection(Graph graph, int communityCount, vector<pair<int, int>> addedEdges, vector<pair<int, int>> removedEdges, int stopBefore = -1, ofstream* outfile = nullptr);
+        ApproximateCommunityDetection(const Graph& graph, int communityCount, const vector<pair<int, int>>& addedEdges, const vector<pair<int, int>>& removedEdges, int stopBefore = -1, ofstream* outfile = nullptr, NodeOrder nodeOrder = NodeOrder::None);
+        ApproximateCommunityDetection(const Graph& graph, int communityCount, EdgeStream& events, int stopBefore = -1, ofstream* outfile = nullptr, NodeOrder nodeOrder = NodeOrder::None);
         ~ApproximateCommunityDetection();
 };
 
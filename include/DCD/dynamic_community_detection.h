@@ -2,6 +2,8 @@
 #define DYNAMIC_COMMUNITY_DETECTION_H
 
 #include "src/graph.h"
+#include "src/csr_graph.h"
+#include "src/edge_stream.h"
 #include "utils/quality_measures.h"
 #include <numeric>
 #include <vector>
@@ -20,7 +22,7 @@ class DynamicCommunityDetection {
     private:
         Graph c_ul;
         int communityCount;
-        int totalEdges;
+        long long totalEdges;
         random_device rd;
         double epsilon_gain = 0.0001;
 
@@ -35,11 +37,15 @@ class DynamicCommunityDetection {
         // void mergeCommunities();
         double modularity_gain(const Node* node, int new_community, int old_community);
         void relabelGraph();
+        // Keeps the stream of the edge list constructor alive for the delegated call
+        DynamicCommunityDetection(const Graph& graph, int communityCount, EdgeStream&& events, NodeOrder nodeOrder);
 
     public:
         Graph c_ll;
 
-        DynamicCommunityDetection(Graph graph, int communityCount, vector<pair<int, int>> addedEdges, vector<pair<int, int>> removedEdges);
+        DynamicCommunityDetection(const Graph& graph, int communityCount, const vector<pair<int, int>>& addedEdges, const vector<pair<int, int>>& removedEdges, NodeOrder nodeOrder = NodeOrder::None);
+        // Applies events in stream order, one per local moving round
+        DynamicCommunityDetection(const Graph& graph, int communityCount, EdgeStream& events, NodeOrder nodeOrder = NodeOrder::None);
         ~DynamicCommunityDetection();
 };
 
@@ -2,6 +2,7 @@
 #define IP_SOLVER_H
 
 #include "src/graph.h"
+#include "src/edge_stream.h"
 #include "ortools/linear_solver/linear_solver.h"
 #include <thread>
 
@@ -14,11 +15,13 @@ class IPSolver {
     public:
         Graph ip_graph;
 
-        IPSolver(Graph graph, int numberCommunities, vector<pair<int, int>> addedEdges, vector<pair<int, int>> removedEdges);
+        IPSolver(const Graph& graph, int numberCommunities, const vector<pair<int, int>>& addedEdges, const vector<pair<int, int>>& removedEdges, NodeOrder nodeOrder = NodeOrder::None);
+        // The ILP is solved once on the final graph, events are applied to it as they arrive
+        IPSolver(const Graph& graph, int numberCommunities, EdgeStream& events, NodeOrder nodeOrder = NodeOrder::None);
         ~IPSolver();
 
     private:
-        int total_edges;
+        long long total_edges;
         int numberCommunities;
 
         // Stop when gap <= 10%
@@ -2,6 +2,8 @@
 #define BELIEF_PROPAGATION_H
 
 #include "src/graph.h"
+#include "src/edge_stream.h"
+#include "src/message_kernel.h"
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
@@ -19,9 +21,14 @@ class BeliefPropagation {
     public:
         Graph bp_graph;
 
-        BeliefPropagation(Graph graph, int communityCount, int impactRadius, double intra_community_edge_probability, double inter_community_edge_probability, vector<pair<int, int>> addedEdges, vector<pair<int, int>> removedEdges);
+        BeliefPropagation(const Graph& graph, int communityCount, int impactRadius, double intra_community_edge_probability, double inter_community_edge_probability, const vector<pair<int, int>>& addedEdges, const vector<pair<int, int>>& removedEdges, NodeOrder nodeOrder = NodeOrder::None, MessageScaling scaling = MessageScaling::Product);
+        BeliefPropagation(const Graph& graph, int communityCount, int impactRadius, double intra_community_edge_probability, double inter_community_edge_probability, EdgeStream& events, NodeOrder nodeOrder = NodeOrder::None, MessageScaling scaling = MessageScaling::Product);
         ~BeliefPropagation();
 
+        // True when the edge id bookkeeping matches bp_graph: every edge list slot has a live id paired with the
+        // id of the opposite direction, and no freed id is still referenced
+        bool edgeIdsConsistent() const;
+
     private:
         int impactRadius;
         int communityCount;
@@ -32,9 +39,42 @@ class BeliefPropagation {
         mt19937 gen;
         unordered_map<int, int> sideInformation;    // Side information for now is noise labels
 
+        // Messages of all directed edges in one array, communityCount values per directed edge id. Ids are handed
+        // out as edges are added and reused after removal.
+        vector<double> messages;
+        // incomingEdges[i][slot] is the id of the edge into the node at dense index i from its neighbor in that
+        // edgeList slot, kept parallel to the edge list
+        vector<vector<int>> incomingEdges;
+        // Id of the opposite direction of every edge id
+        vector<int> reverseEdge;
+        vector<int> freeEdgeIds;
+        vector<double> messageBuffer;
+        // BP_0 of every noise label, communityCount values each, and a last row for labels outside the communities
+        vector<double> priors;
+        MessageKernel kernel;
+        MessageScaling scaling;
+        // Exponents of the message being recomputed in Rescaled mode and the rescale interval of every prior row
+        vector<int64_t> exponentBuffer;
+        vector<size_t> rescaleIntervals;
+
+        // Edge from parent to node of an R-neighborhood, with the id of that direction
+        struct NeighborhoodEdge {
+            Node* node;
+            Node* parent;
+            int edgeId;
+        };
+
+        // Keeps the stream of the edge list constructor alive for the delegated call
+        BeliefPropagation(const Graph& graph, int communityCount, int impactRadius, double intra_community_edge_probability, double inter_community_edge_probability, EdgeStream&& events, NodeOrder nodeOrder, MessageScaling scaling);
+        void indexEdges();
+        int allocateEdgeId();
+        void addEdge(int node1Id, int node2Id);
+        void removeEdge(int node1Id, int node2Id);
+        void detachSlot(Node* node, int slot);
+        double* message(int edgeId) { return messages.data() + size_t(edgeId) * communityCount; }
         void processVertex(int nodeId, int involvedNeighborId);
-        vector<double> StreamBP(const Node* node, const vector<int> excludedNodeIds, int noiseLabel);
-        unordered_map<int, vector<pair<Node*, Node*>>> collectRNeighborhood(Node* node, int radius);
+        void StreamBP(const Node* node, const vector<int>& excludedNodeIds, int noiseLabel, double* result);
+        unordered_map<int, vector<NeighborhoodEdge>> collectRNeighborhood(Node* node, int radius);
         double BP_0(int noiseLabel, int currentCommunity) const;
         void updateLabels();
 };
@@ -0,0 +1,122 @@
+#include "hub_benchmark.h"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+vector<pair<int, int>> generate_chung_lu_edges(int numberNodes, size_t numberEdges, double exponent, mt19937& gen) {
+    // Node i gets weight proportional to (i + 1)^(-1 / (exponent - 1)), endpoints are drawn proportional to weight
+    vector<double> weights(numberNodes);
+    for (int i = 0; i < numberNodes; ++i) {
+        weights[i] = pow(i + 1.0, -1.0 / (exponent - 1.0));
+    }
+    discrete_distribution<int> endpoint(weights.begin(), weights.end());
+
+    vector<pair<int, int>> edges;
+    edges.reserve(numberEdges);
+    while (edges.size() < numberEdges) {
+        int src = endpoint(gen);
+        int dest = endpoint(gen);
+        if (src != dest) {
+            edges.emplace_back(src, dest);
+        }
+    }
+    return edges;
+}
+
+namespace {
+    struct HubRun {
+        double insertMs;
+        double lookupMs;
+        double removeMs;
+        size_t hubs;
+        // Sum of the looked up weights, printed so the lookups can't be optimized away
+        long long lookupChecksum;
+    };
+
+    // The hub threshold is shared by all graphs of the process, restore it however the run ends
+    class HubThresholdScope {
+        public:
+            explicit HubThresholdScope(size_t threshold): previousThreshold(Node::getHubThreshold()) {
+                Node::setHubThreshold(threshold);
+            }
+            ~HubThresholdScope() {
+                Node::setHubThreshold(previousThreshold);
+            }
+
+        private:
+            size_t previousThreshold;
+    };
+
+    HubRun time_hub_workload(int numberNodes, const vector<pair<int, int>>& edges, size_t threshold) {
+        HubThresholdScope scope(threshold);
+
+        HubRun run{};
+        Graph graph(numberNodes);
+        auto start = chrono::high_resolution_clock::now();
+        for (const auto& [src, dest]: edges) {
+            graph.addUndirectedEdge(src, dest);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        run.insertMs = chrono::duration<double, milli>(end - start).count();
+
+        for (const auto& node: graph.nodes) {
+            run.hubs += node->isHub();
+        }
+
+        // Lookups of edges that may or may not exist, both directions
+        start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < edges.size(); ++i) {
+            run.lookupChecksum += graph.getEdgeWeight(edges[i].first, edges[edges.size() - 1 - i].second);
+        }
+        end = chrono::high_resolution_clock::now();
+        run.lookupMs = chrono::duration<double, milli>(end - start).count();
+
+        // Remove every other edge, hubs shrink toward the demotion point
+        start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < edges.size(); i += 2) {
+            graph.removeUndirectedEdge(edges[i].first, edges[i].second);
+        }
+        end = chrono::high_resolution_clock::now();
+        run.removeMs = chrono::duration<double, milli>(end - start).count();
+
+        return run;
+    }
+}
+
+void run_hub_benchmark() {
+    vector<tuple<int, size_t, double>> inputs = {
+        {20000, 200000, 2.5},
+        {20000, 200000, 2.1},
+        {100000, 1000000, 2.1},
+    };
+
+    mt19937 gen(42);
+    long long lookupChecksum = 0;
+    for (const auto& [numberNodes, numberEdges, exponent]: inputs) {
+        vector<pair<int, int>> edges = generate_chung_lu_edges(numberNodes, numberEdges, exponent, gen);
+
+        // Share of edge endpoints on the top 1% of nodes shows how skewed the input is
+        vector<int> degrees(numberNodes, 0);
+        for (const auto& [src, dest]: edges) {
+            degrees[src]++;
+            degrees[dest]++;
+        }
+        sort(degrees.begin(), degrees.end(), greater<int>());
+        long long topEndpoints = accumulate(degrees.begin(), degrees.begin() + max(1, numberNodes / 100), 0LL);
+
+        cout << "Chung-Lu n=" << numberNodes << " m=" << numberEdges << " exponent=" << exponent
+            << ", max degree " << degrees.front()
+            << ", top 1% of nodes hold " << 100.0 * topEndpoints / (2.0 * numberEdges) << "% of endpoints" << endl;
+
+        for (size_t threshold: {numeric_limits<size_t>::max(), Node::getHubThreshold()}) {
+            HubRun run = time_hub_workload(numberNodes, edges, threshold);
+            lookupChecksum += run.lookupChecksum;
+            cout << "  " << (threshold == numeric_limits<size_t>::max() ? "flat edge lists " : "hub promotion   ")
+                << "insert " << run.insertMs << " ms, lookup " << run.lookupMs << " ms, remove " << run.removeMs
+                << " ms, hubs " << run.hubs << endl;
+        }
+    }
+    cout << "Lookup checksum " << lookupChecksum << endl;
+}
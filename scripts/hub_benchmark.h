@@ -0,0 +1,17 @@
+#ifndef HUB_BENCHMARK_H
+#define HUB_BENCHMARK_H
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "src/graph.h"
+
+using namespace std;
+
+// Chung–Lu edges over numberNodes nodes whose expected degrees follow a power law with the given exponent
+vector<pair<int, int>> generate_chung_lu_edges(int numberNodes, size_t numberEdges, double exponent, mt19937& gen);
+// Times edge insertion, lookup and removal on a heavy-tailed graph with hub promotion disabled and enabled
+void run_hub_benchmark();
+
+#endif // HUB_BENCHMARK_H
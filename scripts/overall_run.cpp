@@ -1,5 +1,49 @@
 #include "overall_run.h"
 
+// Reads labels.txt and edges.txt of a test data directory, removed edges are not used for now
+void read_text_test_data(const filesystem::path& directory, Graph& graph, vector<pair<int, int>>& addedEdges) {
+    // Read labels file
+    ifstream labels_stream(directory / "labels.txt");
+    int node_id, label, offset;
+    while (labels_stream >> node_id >> label >> offset) {
+        Node* node = graph.getNode(node_id);
+        graph.setLabel(node, label);
+        node->offset = offset;
+    }
+
+    // Read edges file
+    ifstream edges_stream(directory / "edges.txt");
+    int node1_id, node2_id;
+    while (edges_stream >> node1_id >> node2_id) {
+        addedEdges.push_back({node1_id, node2_id});
+    }
+}
+
+// Writes graph.bin and edges.bin next to the text files of every test data directory
+void convert_test_data() {
+    if (!filesystem::exists(TEST_DATA_DIRECTORY) || !filesystem::is_directory(TEST_DATA_DIRECTORY)) {
+        cerr << "Test data directory not found. Please check the path." << endl;
+        return;
+    }
+
+    for (const auto& subdirectory: filesystem::directory_iterator(TEST_DATA_DIRECTORY)) {
+        if (!subdirectory.is_directory()) {
+            continue;
+        }
+        vector<string> tokens = splitString(subdirectory.path().filename(), '_');
+        Graph graph(stoi(tokens[0]));
+        vector<pair<int, int>> addedEdges{};
+        read_text_test_data(subdirectory.path(), graph, addedEdges);
+
+        CsrGraph(graph).writeFile(subdirectory.path() / "graph.bin");
+        filesystem::path edges_binary = subdirectory.path() / "edges.bin";
+        filesystem::remove(edges_binary);
+        EdgeEventWriter writer(edges_binary);
+        writer.append(addedEdges, EdgeOp::Add);
+        writer.flush();
+    }
+}
+
 void run_all_algorithms(bool draw_graphs) {
     // Run the test script
     if (!filesystem::exists(TEST_DATA_DIRECTORY) || !filesystem::is_directory(TEST_DATA_DIRECTORY)) {
@@ -32,27 +76,19 @@ void run_all_algorithms(bool draw_graphs) {
 
         Sbm sbm(nodes, communities, intra_community_edge_probability, inter_community_edge_probability);
 
-        // Read labels file
-        filesystem::path labels_file = subdirectory.path() / "labels.txt";
-        ifstream labels_stream(labels_file);
-        int node_id, label, offset;
-        while (labels_stream >> node_id >> label >> offset) {
-            Node* node = sbm.sbm_graph.getNode(node_id);
-            node->label = label;
-            node->offset = offset;
-        }
-
-        // Read edges file
-        filesystem::path edges_file = subdirectory.path() / "edges.txt";
-        ifstream edges_stream(edges_file);
-        int node1_id, node2_id;
         vector<pair<int, int>> addedEdges{};
-        while (edges_stream >> node1_id >> node2_id) {
-            addedEdges.push_back({node1_id, node2_id});
-        }
-
-        // Not using removed edges for now
         vector<pair<int, int>> removedEdges{};
+        filesystem::path graph_binary = subdirectory.path() / "graph.bin";
+        filesystem::path edges_binary = subdirectory.path() / "edges.bin";
+        if (filesystem::exists(graph_binary) && filesystem::exists(edges_binary)) {
+            // Binary inputs written by convert_test_data, mapped instead of parsed
+            sbm.sbm_graph = Graph(CsrGraph::mapFile(graph_binary));
+            MappedEdgeEvents edge_events(edges_binary);
+            addedEdges.reserve(edge_events.size());
+            edge_events.split(addedEdges, removedEdges);
+        } else {
+            read_text_test_data(subdirectory.path(), sbm.sbm_graph, addedEdges);
+        }
 
         if (draw_graphs) {
             sbm.sbm_graph.draw(result_directory + string("/original.png"));
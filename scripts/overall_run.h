@@ -3,15 +3,20 @@
 
 #include <iostream>
 #include "src/sbm.h"
+#include "src/csr_graph.h"
+#include "src/edge_events.h"
 #include "dynamic_community_detection.h"
 #include "belief_propagation.h"
 #include "approximate_community_detection.h"
 #include "ip_solver.h"
 #include <fstream>
+#include <filesystem>
 #include "utils/utilities.h"
 
 using namespace std;
 
+void read_text_test_data(const filesystem::path& directory, Graph& graph, vector<pair<int, int>>& addedEdges);
+void convert_test_data();
 void run_all_algorithms(bool draw_graphs = false);
 
 #endif // TEST_SCRIPT_H
@@ -0,0 +1,42 @@
+#include "alias_table.h"
+
+#include <numeric>
+
+AliasTable::AliasTable(const vector<double>& weights): probabilities(weights.size()), aliases(weights.size()) {
+    double total = accumulate(weights.begin(), weights.end(), 0.0);
+    if (weights.empty() || !(total > 0.0)) {
+        throw invalid_argument("AliasTable: Expected at least one positive weight.");
+    }
+
+    // Scale so the average slot holds 1, then pair every underfull slot with an overfull one
+    vector<size_t> small;
+    vector<size_t> large;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        if (weights[i] < 0.0) {
+            throw invalid_argument("AliasTable: Weights must not be negative.");
+        }
+        probabilities[i] = weights[i] * weights.size() / total;
+        aliases[i] = i;
+        (probabilities[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        size_t underfull = small.back();
+        small.pop_back();
+        size_t overfull = large.back();
+        aliases[underfull] = overfull;
+        probabilities[overfull] -= 1.0 - probabilities[underfull];
+        if (probabilities[overfull] < 1.0) {
+            large.pop_back();
+            small.push_back(overfull);
+        }
+    }
+
+    // Leftovers are 1 up to rounding
+    for (size_t i: small) {
+        probabilities[i] = 1.0;
+    }
+    for (size_t i: large) {
+        probabilities[i] = 1.0;
+    }
+}
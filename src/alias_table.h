@@ -0,0 +1,32 @@
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include <vector>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+
+// Walker/Vose alias table: O(n) construction, then O(1) draws of index i with probability weights[i] / sum(weights)
+class AliasTable {
+    public:
+        AliasTable() = default;
+        explicit AliasTable(const vector<double>& weights);
+
+        size_t size() const { return probabilities.size(); }
+        bool empty() const { return probabilities.empty(); }
+
+        // One uniform slot and one biased coin
+        template <typename Generator>
+        size_t sample(Generator& gen) const {
+            size_t slot = uniform_int_distribution<size_t>(0, probabilities.size() - 1)(gen);
+            return (uniform_real_distribution<double>(0.0, 1.0)(gen) < probabilities[slot]) ? slot : aliases[slot];
+        }
+
+    private:
+        vector<double> probabilities;
+        vector<size_t> aliases;
+};
+
+#endif // ALIAS_TABLE_H
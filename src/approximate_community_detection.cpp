@@ -2,12 +2,31 @@
 
 
 ApproximateCommunityDetection::ApproximateCommunityDetection(
-    Graph graph,
+    const Graph& graph,
     int communityCount,
-    vector<pair<int, int>> addedEdges,
-    vector<pair<int, int>> removedEdges,
+    const vector<pair<int, int>>& addedEdges,
+    const vector<pair<int, int>>& removedEdges,
     int stopBefore,
-    ofstream* outfile
+    ofstream* outfile,
+    NodeOrder nodeOrder
+): ApproximateCommunityDetection(graph, communityCount, VectorEdgeStream(addedEdges, removedEdges), stopBefore, outfile, nodeOrder) {}
+
+ApproximateCommunityDetection::ApproximateCommunityDetection(
+    const Graph& graph,
+    int communityCount,
+    EdgeStream&& events,
+    int stopBefore,
+    ofstream* outfile,
+    NodeOrder nodeOrder
+): ApproximateCommunityDetection(graph, communityCount, events, stopBefore, outfile, nodeOrder) {}
+
+ApproximateCommunityDetection::ApproximateCommunityDetection(
+    const Graph& graph,
+    int communityCount,
+    EdgeStream& events,
+    int stopBefore,
+    ofstream* outfile,
+    NodeOrder nodeOrder
 ):
     acd_graph(graph),
     communityCount(communityCount),
@@ -15,6 +34,8 @@ ApproximateCommunityDetection::ApproximateCommunityDetection(
     gen(random_device{}()),
     stopBefore(stopBefore)
 {
+    acd_graph.reorderNodes(nodeOrder);
+
     // Assign nodes to random community
     initializePartition();
     createCommunities();
@@ -28,10 +49,14 @@ ApproximateCommunityDetection::ApproximateCommunityDetection(
     }
 
     // Add edges and update communities
-    // TODO: Time to implement node removal functionality
+    // TODO: Time to implement node removal functionality, skipping removals would leave communities built on dead edges
     int index = 0;
-    for (const auto& [src_id, dest_id]: addedEdges) {
-        auto [src_community, dest_community] = addEdge(src_id, dest_id);
+    EdgeEvent event;
+    while (events.next(event)) {
+        if (event.op != EdgeOp::Add) {
+            throw runtime_error("ApproximateCommunityDetection does not support edge removals");
+        }
+        auto [src_community, dest_community] = addEdge(event.src, event.dest);
         index++;
 
         // Skip if both nodes are in the same community
@@ -84,7 +109,7 @@ void ApproximateCommunityDetection::initializePartition() {
 
             // Assign labels to vertices
             Node* node = acd_graph.getNode(num);
-            node->label = i;
+            acd_graph.setLabel(node, i);
             node->offset = j;
         }
     }
@@ -205,7 +230,7 @@ void ApproximateCommunityDetection::run2FMAlgorithm(Community& comm1, Community&
         main_community->node_removal_priority_queue.popElement();
         main_community->nodes.erase(node_moved);
         other_community->nodes.insert(node_moved);
-        node_moved->label = other_community->id;
+        acd_graph.setLabel(node_moved, other_community->id);
 
         // Update frozen node ids
         frozen_node_ids.insert(node_moved->id);
@@ -331,7 +356,7 @@ void ApproximateCommunityDetection::updateCommunity(Community& comm, unordered_s
 
     // Update node labels
     for (auto& node: comm.nodes) {
-        node->label = comm.id;
+        acd_graph.setLabel(node, comm.id);
     }
 
     // Update e_in, e_out
@@ -388,7 +413,7 @@ bool ApproximateCommunityDetection::runKFMAlgorithm() {
         }
         main_comm->nodes.erase(node_moved);
         other_comm->nodes.insert(node_moved);
-        node_moved->label = other_comm->id;
+        acd_graph.setLabel(node_moved, other_comm->id);
 
         // Update frozen node ids
         frozen_node_ids.insert(node_moved->id);
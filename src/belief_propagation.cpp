@@ -2,21 +2,62 @@
 
 
 BeliefPropagation::BeliefPropagation(
-    Graph graph,
+    const Graph& graph,
     int communityCount,
     int impactRadius,
     double intra_community_edge_probability,
     double inter_community_edge_probability,
-    vector<pair<int, int>> addedEdges,
-    vector<pair<int, int>> removedEdges
+    const vector<pair<int, int>>& addedEdges,
+    const vector<pair<int, int>>& removedEdges,
+    NodeOrder nodeOrder,
+    MessageScaling scaling
+): BeliefPropagation(graph, communityCount, impactRadius, intra_community_edge_probability, inter_community_edge_probability, VectorEdgeStream(addedEdges, removedEdges), nodeOrder, scaling) {}
+
+BeliefPropagation::BeliefPropagation(
+    const Graph& graph,
+    int communityCount,
+    int impactRadius,
+    double intra_community_edge_probability,
+    double inter_community_edge_probability,
+    EdgeStream&& events,
+    NodeOrder nodeOrder,
+    MessageScaling scaling
+): BeliefPropagation(graph, communityCount, impactRadius, intra_community_edge_probability, inter_community_edge_probability, events, nodeOrder, scaling) {}
+
+BeliefPropagation::BeliefPropagation(
+    const Graph& graph,
+    int communityCount,
+    int impactRadius,
+    double intra_community_edge_probability,
+    double inter_community_edge_probability,
+    EdgeStream& events,
+    NodeOrder nodeOrder,
+    MessageScaling scaling
 ):
     bp_graph(graph),
-    communityCount(communityCount),
     impactRadius(impactRadius),
+    communityCount(communityCount),
     intra_community_edge_probability(intra_community_edge_probability),
     inter_community_edge_probability(inter_community_edge_probability),
-    alphaValue(1 - 1 / communityCount)
+    alphaValue(1 - 1 / communityCount),
+    scaling(scaling)
 {
+    bp_graph.reorderNodes(nodeOrder);
+    messageBuffer.resize(communityCount);
+    exponentBuffer.resize(communityCount);
+    indexEdges();
+
+    // The prior only depends on the noise label, so it is tabulated once instead of evaluated per neighbor
+    kernel = bestMessageKernel();
+    priors.resize(size_t(communityCount + 1) * communityCount);
+    for (int row = 0; row <= communityCount; ++row) {
+        int noiseLabel = (row < communityCount) ? row : -1;
+        for (int s = 0; s < communityCount; ++s) {
+            priors[size_t(row) * communityCount + s] = BP_0(noiseLabel, s);
+        }
+        rescaleIntervals.push_back(messageRescaleInterval(priors.data() + size_t(row) * communityCount, communityCount, inter_community_edge_probability, intra_community_edge_probability - inter_community_edge_probability));
+    }
+
     // Initialize noise as random numbers
     mt19937 gen(rd());
     uniform_int_distribution<int> dist(0, communityCount - 2);
@@ -34,26 +75,20 @@ BeliefPropagation::BeliefPropagation(
         sideInformation.emplace(node->id, noiseCommunity);
     }
 
-    // Add edge and update corresponding message vector
-    for (const auto& [node1Id, node2Id]: addedEdges) {
+    // Add or remove edge and update corresponding message vector
+    EdgeEvent event;
+    while (events.next(event)) {
         // Skip self edges
-        if (node1Id == node2Id) {
+        if (event.src == event.dest) {
             continue;
         }
-        bp_graph.addUndirectedEdge(node1Id, node2Id);
-        processVertex(node1Id, node2Id);
-        processVertex(node2Id, node1Id);
-    }
-
-    // Remove edge and update corresponding message vector
-    for (const auto& [node1Id, node2Id]: removedEdges) {
-        // Skip self edges
-        if (node1Id == node2Id) {
-            continue;
+        if (event.op == EdgeOp::Add) {
+            addEdge(event.src, event.dest);
+        } else {
+            removeEdge(event.src, event.dest);
         }
-        bp_graph.removeUndirectedEdge(node1Id, node2Id);
-        processVertex(node1Id, node2Id);
-        processVertex(node2Id, node1Id);
+        processVertex(event.src, event.dest);
+        processVertex(event.dest, event.src);
     }
 
     updateLabels();
@@ -63,6 +98,128 @@ BeliefPropagation::~BeliefPropagation() {
     // Nothing to clean
 }
 
+void BeliefPropagation::indexEdges() {
+    incomingEdges.assign(bp_graph.nodes.size(), {});
+    for (const auto& node: bp_graph.nodes) {
+        incomingEdges[node->getDenseIndex()].assign(node->edgeList.size(), -1);
+    }
+
+    // Pair up both directions of the edges already in the graph
+    for (const auto& node: bp_graph.nodes) {
+        vector<int>& nodeEdges = incomingEdges[node->getDenseIndex()];
+        for (size_t slot = 0; slot < node->edgeList.size(); ++slot) {
+            if (nodeEdges[slot] != -1) {
+                continue;
+            }
+            Node* neighbor = node->edgeList[slot].first;
+            int incoming = allocateEdgeId();
+            if (neighbor == node.get()) {
+                reverseEdge[incoming] = incoming;
+                nodeEdges[slot] = incoming;
+                continue;
+            }
+            int outgoing = allocateEdgeId();
+            reverseEdge[incoming] = outgoing;
+            reverseEdge[outgoing] = incoming;
+            nodeEdges[slot] = incoming;
+            incomingEdges[neighbor->getDenseIndex()][neighbor->findEdge(node->id)] = outgoing;
+        }
+    }
+}
+
+int BeliefPropagation::allocateEdgeId() {
+    int edgeId;
+    if (!freeEdgeIds.empty()) {
+        edgeId = freeEdgeIds.back();
+        freeEdgeIds.pop_back();
+    } else {
+        edgeId = reverseEdge.size();
+        reverseEdge.push_back(-1);
+        messages.resize(messages.size() + communityCount);
+    }
+    // Uninformed until the first update
+    fill(message(edgeId), message(edgeId) + communityCount, 1.0 / communityCount);
+    return edgeId;
+}
+
+void BeliefPropagation::addEdge(int node1Id, int node2Id) {
+    Node* node1 = bp_graph.getNode(node1Id);
+    Node* node2 = bp_graph.getNode(node2Id);
+    bp_graph.addUndirectedEdge(node1, node2);
+
+    // An existing edge only gains weight and keeps its ids
+    vector<int>& node1Edges = incomingEdges[node1->getDenseIndex()];
+    if (node1Edges.size() == node1->edgeList.size()) {
+        return;
+    }
+    int forward = allocateEdgeId();
+    int backward = allocateEdgeId();
+    reverseEdge[forward] = backward;
+    reverseEdge[backward] = forward;
+    node1Edges.push_back(backward);
+    incomingEdges[node2->getDenseIndex()].push_back(forward);
+}
+
+void BeliefPropagation::removeEdge(int node1Id, int node2Id) {
+    Node* node1 = bp_graph.getNode(node1Id);
+    Node* node2 = bp_graph.getNode(node2Id);
+    int slot1 = node1->findEdge(node2Id);
+    int slot2 = node2->findEdge(node1Id);
+    bp_graph.removeUndirectedEdge(node1Id, node2Id);
+
+    if (slot1 != -1) {
+        freeEdgeIds.push_back(incomingEdges[node1->getDenseIndex()][slot1]);
+        detachSlot(node1, slot1);
+    }
+    if (slot2 != -1) {
+        freeEdgeIds.push_back(incomingEdges[node2->getDenseIndex()][slot2]);
+        detachSlot(node2, slot2);
+    }
+}
+
+void BeliefPropagation::detachSlot(Node* node, int slot) {
+    // Same swap with the last entry as Node::removeEdge
+    vector<int>& nodeEdges = incomingEdges[node->getDenseIndex()];
+    nodeEdges[slot] = nodeEdges.back();
+    nodeEdges.pop_back();
+}
+
+bool BeliefPropagation::edgeIdsConsistent() const {
+    if (incomingEdges.size() != bp_graph.nodes.size() || messages.size() != reverseEdge.size() * communityCount) {
+        return false;
+    }
+
+    // Every id is either referenced by exactly one slot or free, never both
+    vector<int> references(reverseEdge.size(), 0);
+    for (int edgeId: freeEdgeIds) {
+        if (edgeId < 0 || edgeId >= (int) reverseEdge.size() || references[edgeId]++ != 0) {
+            return false;
+        }
+    }
+    for (const auto& node: bp_graph.nodes) {
+        const vector<int>& nodeEdges = incomingEdges[node->getDenseIndex()];
+        if (nodeEdges.size() != node->edgeList.size()) {
+            return false;
+        }
+        for (size_t slot = 0; slot < nodeEdges.size(); ++slot) {
+            int incoming = nodeEdges[slot];
+            if (incoming < 0 || incoming >= (int) reverseEdge.size() || references[incoming]++ != 0) {
+                return false;
+            }
+            // The reverse of the edge into node is the edge into the neighbor from node
+            const Node* neighbor = node->edgeList[slot].first;
+            int neighborSlot = neighbor->findEdge(node->id);
+            if (neighborSlot == -1 || incomingEdges[neighbor->getDenseIndex()][neighborSlot] != reverseEdge[incoming]) {
+                return false;
+            }
+            if (reverseEdge[reverseEdge[incoming]] != incoming) {
+                return false;
+            }
+        }
+    }
+    return count(references.begin(), references.end(), 1) == (long) references.size();
+}
+
 void BeliefPropagation::processVertex(int nodeId, int involvedNeighborId) {
     Node* node = bp_graph.getNode(nodeId);
 
@@ -71,23 +228,26 @@ void BeliefPropagation::processVertex(int nodeId, int involvedNeighborId) {
     }
 
     // Update incoming messsages for the new vertex
-    for (const auto& edge: node->edgeList) {
-        Node* neighbor = edge.first;
+    const vector<int>& nodeEdges = incomingEdges[node->getDenseIndex()];
+    for (size_t slot = 0; slot < node->edgeList.size(); ++slot) {
+        Node* neighbor = node->edgeList[slot].first;
 
         // Skip if the neighbor was added in current iteration
         if (neighbor->id == involvedNeighborId) {
             continue;
         }
 
-        neighbor->messages[nodeId] = StreamBP(neighbor, {nodeId, involvedNeighborId}, sideInformation.at(neighbor->id));
+        StreamBP(neighbor, {nodeId, involvedNeighborId}, sideInformation.at(neighbor->id), messageBuffer.data());
+        copy(messageBuffer.begin(), messageBuffer.end(), message(nodeEdges[slot]));
     }
 
     // Update outgoing messages up to `impactRadius` hops
-    unordered_map<int, vector<pair<Node*, Node*>>> RNeighborhood = collectRNeighborhood(node, impactRadius);
+    unordered_map<int, vector<NeighborhoodEdge>> RNeighborhood = collectRNeighborhood(node, impactRadius);
     for (int radius = 1; radius <= impactRadius; ++radius) {
         if (RNeighborhood.find(radius) != RNeighborhood.end()) {
-            for (const auto& [rNode, rParent]: RNeighborhood.at(radius)) {
-                rParent->messages[rNode->id] = StreamBP(rParent, {nodeId, involvedNeighborId, rNode->id}, sideInformation.at(rParent->id));
+            for (const auto& [rNode, rParent, edgeId]: RNeighborhood.at(radius)) {
+                StreamBP(rParent, {nodeId, involvedNeighborId, rNode->id}, sideInformation.at(rParent->id), messageBuffer.data());
+                copy(messageBuffer.begin(), messageBuffer.end(), message(edgeId));
             }
         } else {
             cout << "Radius " << radius << " not found in R-Neighborhood." << endl;
@@ -99,34 +259,47 @@ double BeliefPropagation::BP_0(int noiseLabel, int currentCommunity) const {
     return (alphaValue + (communityCount - 1 - communityCount * alphaValue) * (noiseLabel == currentCommunity)) / (communityCount - 1);
 }
 
-vector<double> BeliefPropagation::StreamBP(const Node* node, const vector<int> excludedNodeIds, int noiseLabel) {
-    vector<double> result(communityCount, 1.0);
-
-    for (const auto& edge: node->edgeList) {
-        const Node* neighbor = edge.first;
-
-        // Don't count excluded nodes in message re-calculation
-        if (find(excludedNodeIds.begin(), excludedNodeIds.end(), neighbor->id) != excludedNodeIds.end()) {
-            continue;
-        }
+void BeliefPropagation::StreamBP(const Node* node, const vector<int>& excludedNodeIds, int noiseLabel, double* result) {
+    fill(result, result + communityCount, 1.0);
 
-        for (int s = 0; s < communityCount; ++s) {
-            result[s] *= (inter_community_edge_probability + (intra_community_edge_probability - inter_community_edge_probability) * neighbor->messages.at(node->id)[s]) * BP_0(noiseLabel, s);
+    // Resolve excluded nodes to edge slots once, hubs answer through their neighbor index instead of a scan
+    vector<int> excludedSlots;
+    excludedSlots.reserve(excludedNodeIds.size());
+    for (int excludedNodeId: excludedNodeIds) {
+        int slot = node->findEdge(excludedNodeId);
+        if (slot != -1) {
+            excludedSlots.push_back(slot);
         }
     }
+    sort(excludedSlots.begin(), excludedSlots.end());
+    excludedSlots.erase(unique(excludedSlots.begin(), excludedSlots.end()), excludedSlots.end());
+    excludedSlots.push_back(node->edgeList.size());
 
-    double Z = accumulate(result.begin(), result.end(), 0.0);
-    if (Z != 0) {
-        for (double& val: result) {
-            val /= Z;
+    int row = (noiseLabel >= 0 && noiseLabel < communityCount) ? noiseLabel : communityCount;
+    const double* prior = priors.data() + size_t(row) * communityCount;
+    double difference = intra_community_edge_probability - inter_community_edge_probability;
+    const vector<int>& nodeEdges = incomingEdges[node->getDenseIndex()];
+    // Don't count excluded nodes in message re-calculation, the kernel takes the runs of slots in between
+    int runStart = 0;
+    for (int excludedSlot: excludedSlots) {
+        if (scaling == MessageScaling::Rescaled) {
+            multiplyMessagesRescaled(kernel, result, exponentBuffer.data(), messages.data(), nodeEdges.data() + runStart, excludedSlot - runStart, prior, communityCount, inter_community_edge_probability, difference, rescaleIntervals[row]);
+        } else {
+            multiplyMessages(kernel, result, messages.data(), nodeEdges.data() + runStart, excludedSlot - runStart, prior, communityCount, inter_community_edge_probability, difference);
         }
+        runStart = excludedSlot + 1;
     }
 
-    return result;
+    if (scaling == MessageScaling::Rescaled) {
+        // Also resets the exponents for the next message
+        normalizeRescaledMessage(kernel, result, exponentBuffer.data(), communityCount);
+    } else {
+        normalizeMessage(kernel, result, communityCount);
+    }
 }
 
-unordered_map<int, vector<pair<Node*, Node*>>> BeliefPropagation::collectRNeighborhood(Node* node, int radius) {
-    unordered_map<int, vector<pair<Node*, Node*>>> neighborhood;
+unordered_map<int, vector<BeliefPropagation::NeighborhoodEdge>> BeliefPropagation::collectRNeighborhood(Node* node, int radius) {
+    unordered_map<int, vector<NeighborhoodEdge>> neighborhood;
     unordered_set<int> visitedNodes;
 
     // Custom operator for priority queue to sort by distance
@@ -146,8 +319,9 @@ unordered_map<int, vector<pair<Node*, Node*>>> BeliefPropagation::collectRNeighb
             continue;
         }
 
-        for (const auto& edge: currentNode->edgeList) {
-            Node* nextNode = edge.first;
+        const vector<int>& currentEdges = incomingEdges[currentNode->getDenseIndex()];
+        for (size_t slot = 0; slot < currentNode->edgeList.size(); ++slot) {
+            Node* nextNode = currentNode->edgeList[slot].first;
 
             // Skip loops
             if (visitedNodes.find(nextNode->id) != visitedNodes.end()) {
@@ -157,7 +331,7 @@ unordered_map<int, vector<pair<Node*, Node*>>> BeliefPropagation::collectRNeighb
             int nextDistance = currentDistance + 1;
             if (nextDistance <= radius) {
                 distQueue.emplace(nextNode, nextDistance);
-                neighborhood[nextDistance].emplace_back(nextNode, currentNode);
+                neighborhood[nextDistance].push_back({nextNode, currentNode, reverseEdge[currentEdges[slot]]});
                 visitedNodes.insert(nextNode->id);
             }
         }
@@ -168,7 +342,7 @@ unordered_map<int, vector<pair<Node*, Node*>>> BeliefPropagation::collectRNeighb
 
 void BeliefPropagation::updateLabels() {
     for (auto& node: bp_graph.nodes) {
-        vector<double> message = StreamBP(node.get(), {}, sideInformation.at(node->id));
-        node->label = distance(message.begin(), max_element(message.begin(), message.end()));
+        StreamBP(node.get(), {}, sideInformation.at(node->id), messageBuffer.data());
+        bp_graph.setLabel(node.get(), distance(messageBuffer.begin(), max_element(messageBuffer.begin(), messageBuffer.end())));
     }
 }
@@ -0,0 +1,143 @@
+#include "compressed_csr_graph.h"
+
+#include <algorithm>
+
+
+CompressedCsrGraph::CompressedCsrGraph(const CsrGraph& graph): totalEdges(graph.getTotalEdges()) {
+    int numberNodes = graph.numberNodes();
+    ids.reserve(numberNodes);
+    labels.reserve(numberNodes);
+    degrees.reserve(numberNodes);
+    id_to_index_mapping.reserve(numberNodes);
+    for (int i = 0; i < numberNodes; ++i) {
+        ids.push_back(graph.getId(i));
+        labels.push_back(graph.getLabel(i));
+        degrees.push_back(graph.getDegree(i));
+        id_to_index_mapping.emplace(graph.getId(i), i);
+    }
+
+    bool unitWeights = true;
+    for (int position = 0; position < graph.numberEdgeEntries() && unitWeights; ++position) {
+        unitWeights = graph.getWeight(position) == 1;
+    }
+
+    entryOffsets.reserve(numberNodes + 1);
+    controlOffsets.reserve(numberNodes + 1);
+    neighborOffsets.reserve(numberNodes + 1);
+    neighborControls.reserve(graph.numberEdgeEntries() / 4 + numberNodes);
+    neighborData.reserve(graph.numberEdgeEntries() + streamVBytePadding);
+    entryOffsets.push_back(0);
+    controlOffsets.push_back(0);
+    neighborOffsets.push_back(0);
+    if (!unitWeights) {
+        weightOffsets.reserve(numberNodes + 1);
+        weightOffsets.push_back(0);
+    }
+
+    vector<pair<uint32_t, uint32_t>> sortedEdges;
+    vector<uint32_t> values;
+    for (int i = 0; i < numberNodes; ++i) {
+        sortedEdges.clear();
+        graph.forEachNeighbor(i, [&sortedEdges](int neighbor, int weight) {
+            sortedEdges.emplace_back(neighbor, weight);
+        });
+        sort(sortedEdges.begin(), sortedEdges.end());
+
+        values.clear();
+        for (const auto& edge: sortedEdges) {
+            values.push_back(edge.first);
+        }
+        streamVByteEncode(values.data(), values.size(), true, 0, neighborControls, neighborData);
+
+        if (!unitWeights) {
+            values.clear();
+            for (const auto& edge: sortedEdges) {
+                values.push_back(edge.second);
+            }
+            streamVByteEncode(values.data(), values.size(), false, 0, weightControls, weightData);
+            weightOffsets.push_back(weightData.size());
+        }
+
+        entryOffsets.push_back(entryOffsets.back() + sortedEdges.size());
+        controlOffsets.push_back(neighborControls.size());
+        neighborOffsets.push_back(neighborData.size());
+    }
+
+    // SIMD decoding reads whole 16 byte blocks
+    neighborData.resize(neighborData.size() + streamVBytePadding, 0);
+    if (!unitWeights) {
+        weightData.resize(weightData.size() + streamVBytePadding, 0);
+    }
+    neighborData.shrink_to_fit();
+    neighborControls.shrink_to_fit();
+    weightData.shrink_to_fit();
+    weightControls.shrink_to_fit();
+}
+
+CompressedCsrGraph::CompressedCsrGraph(const Graph& graph): CompressedCsrGraph(CsrGraph(graph)) {}
+
+CompressedCsrGraph::~CompressedCsrGraph() {
+    // Nothing to clean
+}
+
+int CompressedCsrGraph::numberNodes() const {
+    return ids.size();
+}
+
+int CompressedCsrGraph::numberEdgeEntries() const {
+    return entryOffsets.back();
+}
+
+// Total edges includes weight as well
+long long CompressedCsrGraph::getTotalEdges() const {
+    return totalEdges;
+}
+
+int CompressedCsrGraph::getIndex(int nodeId) const {
+    auto it = id_to_index_mapping.find(nodeId);
+    if (it == id_to_index_mapping.end()) {
+        throw out_of_range("Node with id " + to_string(nodeId) + " not found in id to index mapping.");
+    }
+    return it->second;
+}
+
+bool CompressedCsrGraph::hasUnitWeights() const {
+    return weightOffsets.empty();
+}
+
+size_t CompressedCsrGraph::adjacencyBytes() const {
+    return entryOffsets.size() * sizeof(int) + controlOffsets.size() * sizeof(uint32_t)
+        + (neighborOffsets.size() + weightOffsets.size()) * sizeof(uint64_t)
+        + neighborControls.size() + neighborData.size() + weightControls.size() + weightData.size();
+}
+
+CompressedCsrGraph::Cursor CompressedCsrGraph::openCursor(int index) const {
+    Cursor cursor;
+    cursor.control = neighborControls.data() + controlOffsets[index];
+    cursor.neighborData = neighborData.data() + neighborOffsets[index];
+    cursor.weightData = hasUnitWeights() ? nullptr : weightData.data() + weightOffsets[index];
+    cursor.previous = 0;
+    cursor.remaining = getNeighborCount(index);
+    return cursor;
+}
+
+// Decodes up to chunkSize neighbors and weights, returns how many were decoded
+size_t CompressedCsrGraph::decodeChunk(Cursor& cursor, uint32_t* neighbors, uint32_t* weights) const {
+    size_t count = min(cursor.remaining, chunkSize);
+    if (count == 0) {
+        return 0;
+    }
+
+    cursor.neighborData += streamVByteDecode(cursor.control, cursor.neighborData, count, true, cursor.previous, neighbors);
+    if (hasUnitWeights()) {
+        fill(weights, weights + count, 1);
+    } else {
+        // Weight controls mirror neighbor controls position for position
+        const uint8_t* weightControl = weightControls.data() + (cursor.control - neighborControls.data());
+        uint32_t unused = 0;
+        cursor.weightData += streamVByteDecode(weightControl, cursor.weightData, count, false, unused, weights);
+    }
+    cursor.control += (count + 3) / 4;
+    cursor.remaining -= count;
+    return count;
+}
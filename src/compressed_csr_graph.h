@@ -0,0 +1,83 @@
+#ifndef COMPRESSED_CSR_GRAPH_H
+#define COMPRESSED_CSR_GRAPH_H
+
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstdint>
+
+#include "csr_graph.h"
+#include "stream_vbyte.h"
+
+using namespace std;
+
+
+// Read-only CSR snapshot with compressed adjacency: neighbor lists are sorted, delta encoded and packed with
+// Stream VByte, weights are packed the same way without deltas or dropped entirely when every weight is 1.
+// Neighbors are only reachable sequentially through forEachNeighbor.
+class CompressedCsrGraph {
+    public:
+        // Values decoded per step of forEachNeighbor, a multiple of four so steps align with control bytes
+        static constexpr size_t chunkSize = 64;
+
+        explicit CompressedCsrGraph(const CsrGraph& graph);
+        explicit CompressedCsrGraph(const Graph& graph);
+        ~CompressedCsrGraph();
+
+        int numberNodes() const;
+        int numberEdgeEntries() const;
+        long long getTotalEdges() const;
+        int getIndex(int nodeId) const;
+        bool hasUnitWeights() const;
+        // Bytes held by the encoded neighbor and weight streams and their offsets
+        size_t adjacencyBytes() const;
+
+        int getId(int index) const { return ids[index]; }
+        int getLabel(int index) const { return labels[index]; }
+        void setLabel(int index, int label) { labels[index] = label; }
+        int getDegree(int index) const { return degrees[index]; }
+        int getNeighborCount(int index) const { return entryOffsets[index + 1] - entryOffsets[index]; }
+
+        // Calls visit(neighborIndex, weight) for every neighbor in increasing index order
+        template <typename Visitor>
+        void forEachNeighbor(int index, Visitor&& visit) const {
+            uint32_t neighbors[chunkSize];
+            uint32_t weights[chunkSize];
+            Cursor cursor = openCursor(index);
+            size_t count;
+            while ((count = decodeChunk(cursor, neighbors, weights)) > 0) {
+                for (size_t i = 0; i < count; ++i) {
+                    visit(static_cast<int>(neighbors[i]), static_cast<int>(weights[i]));
+                }
+            }
+        }
+
+    private:
+        // Decoding position inside one neighbor list
+        struct Cursor {
+            const uint8_t* control;
+            const uint8_t* neighborData;
+            const uint8_t* weightData;
+            uint32_t previous;
+            size_t remaining;
+        };
+
+        vector<int> entryOffsets;           // size n + 1, neighbor counts as in CsrGraph
+        vector<uint32_t> controlOffsets;    // size n + 1, shared by neighbor and weight streams
+        vector<uint64_t> neighborOffsets;   // size n + 1, byte offsets into neighborData
+        vector<uint64_t> weightOffsets;     // size n + 1, empty with unit weights
+        vector<uint8_t> neighborControls;
+        vector<uint8_t> neighborData;
+        vector<uint8_t> weightControls;
+        vector<uint8_t> weightData;
+        vector<int> ids;
+        vector<int> labels;
+        vector<int> degrees;
+        long long totalEdges;
+        unordered_map<int, int> id_to_index_mapping;
+
+        Cursor openCursor(int index) const;
+        size_t decodeChunk(Cursor& cursor, uint32_t* neighbors, uint32_t* weights) const;
+};
+
+#endif // COMPRESSED_CSR_GRAPH_H
@@ -0,0 +1,226 @@
+#include "concurrent_graph.h"
+
+
+GraphSnapshot::GraphSnapshot(shared_ptr<const GraphVersion> version, size_t blockSize):
+    version(move(version)), blockSize(blockSize) {}
+
+const VersionedNode& GraphSnapshot::getNodeAt(int index) const {
+    return *version->blocks[index / blockSize]->nodes[index % blockSize];
+}
+
+const VersionedNode& GraphSnapshot::getNode(int nodeId) const {
+    auto it = version->id_to_index_mapping->find(nodeId);
+    if (it == version->id_to_index_mapping->end()) {
+        throw out_of_range("Node with id " + to_string(nodeId) + " not found in snapshot.");
+    }
+    return getNodeAt(it->second);
+}
+
+unordered_map<int, int> GraphSnapshot::getLabels() const {
+    unordered_map<int, int> labels;
+    labels.reserve(numberNodes());
+    for (int index = 0; index < numberNodes(); ++index) {
+        const VersionedNode& node = getNodeAt(index);
+        labels.emplace(node.id, node.label);
+    }
+    return labels;
+}
+
+unordered_map<int, set<int>> GraphSnapshot::getCommunities() const {
+    unordered_map<int, set<int>> communities;
+    for (int index = 0; index < numberNodes(); ++index) {
+        const VersionedNode& node = getNodeAt(index);
+        communities[node.label].insert(node.id);
+    }
+    return communities;
+}
+
+Graph GraphSnapshot::toGraph() const {
+    Graph graph(0);
+    graph.nodes.reserve(numberNodes());
+    for (int index = 0; index < numberNodes(); ++index) {
+        const VersionedNode& node = getNodeAt(index);
+        graph.addNode(node.id, node.label);
+    }
+
+    // Graph::addNode appends, so dense indices carry over
+    for (int index = 0; index < numberNodes(); ++index) {
+        Node* src = graph.nodes[index].get();
+        for (const auto& [destIndex, edgeWeight]: getNodeAt(index).edgeList) {
+            graph.addEdge(src, graph.nodes[destIndex].get(), edgeWeight);
+        }
+    }
+    return graph;
+}
+
+ConcurrentGraph::ConcurrentGraph(const Graph& graph, size_t blockSize): blockSize(blockSize) {
+    if (blockSize == 0) {
+        throw invalid_argument("ConcurrentGraph: Block size must be positive.");
+    }
+
+    auto version = make_shared<GraphVersion>();
+    version->epoch = 0;
+    version->numberNodes = graph.nodes.size();
+    version->directedEdgeWeight = 2 * graph.getTotalEdges();
+    version->id_to_index_mapping = make_shared<unordered_map<int, int>>();
+    version->id_to_index_mapping->reserve(graph.nodes.size());
+    for (size_t index = 0; index < graph.nodes.size(); ++index) {
+        version->id_to_index_mapping->emplace(graph.nodes[index]->id, index);
+    }
+
+    for (size_t index = 0; index < graph.nodes.size(); ++index) {
+        if (index % blockSize == 0) {
+            version->blocks.push_back(make_shared<NodeBlock>(NodeBlock{0, {}}));
+            version->blocks.back()->nodes.reserve(blockSize);
+        }
+        const Node* node = graph.nodes[index].get();
+        auto versionedNode = make_shared<VersionedNode>(VersionedNode{0, node->id, node->label, node->degree, {}});
+        versionedNode->edgeList.reserve(node->edgeList.size());
+        for (const auto& edge: node->edgeList) {
+            versionedNode->edgeList.emplace_back(version->id_to_index_mapping->at(edge.first->id), edge.second);
+        }
+        version->blocks.back()->nodes.push_back(move(versionedNode));
+    }
+
+    atomic_store(&published, shared_ptr<const GraphVersion>(move(version)));
+}
+
+ConcurrentGraph::~ConcurrentGraph() {
+    // Nothing to clean
+}
+
+// Starts the next version on the first write after a publish. Only the block pointer list is copied, blocks and
+// nodes are copied lazily by mutableNode.
+GraphVersion& ConcurrentGraph::nextVersion() {
+    if (!pending) {
+        shared_ptr<const GraphVersion> current = atomic_load(&published);
+        pending = make_shared<GraphVersion>(*current);
+        pending->epoch = current->epoch + 1;
+    }
+    return *pending;
+}
+
+int ConcurrentGraph::getIndex(int nodeId) {
+    const unordered_map<int, int>& mapping = *nextVersion().id_to_index_mapping;
+    auto it = mapping.find(nodeId);
+    if (it == mapping.end()) {
+        throw out_of_range("Node with id " + to_string(nodeId) + " not found in id to index mapping.");
+    }
+    return it->second;
+}
+
+VersionedNode* ConcurrentGraph::mutableNode(int index) {
+    GraphVersion& version = nextVersion();
+    shared_ptr<NodeBlock>& block = version.blocks[index / blockSize];
+    if (block->epoch != version.epoch) {
+        block = make_shared<NodeBlock>(*block);
+        block->epoch = version.epoch;
+    }
+    shared_ptr<VersionedNode>& node = block->nodes[index % blockSize];
+    if (node->epoch != version.epoch) {
+        node = make_shared<VersionedNode>(*node);
+        node->epoch = version.epoch;
+    }
+    return node.get();
+}
+
+void ConcurrentGraph::addNode(int nodeId, int nodeLabel) {
+    GraphVersion& version = nextVersion();
+    if (version.id_to_index_mapping->count(nodeId)) {
+        throw invalid_argument("Node with id " + to_string(nodeId) + " already exists.");
+    }
+    if (version.id_to_index_mapping == atomic_load(&published)->id_to_index_mapping) {
+        version.id_to_index_mapping = make_shared<unordered_map<int, int>>(*version.id_to_index_mapping);
+    }
+
+    int index = version.numberNodes;
+    if (index % blockSize == 0) {
+        version.blocks.push_back(make_shared<NodeBlock>(NodeBlock{version.epoch, {}}));
+        version.blocks.back()->nodes.reserve(blockSize);
+    } else if (version.blocks.back()->epoch != version.epoch) {
+        version.blocks.back() = make_shared<NodeBlock>(*version.blocks.back());
+        version.blocks.back()->epoch = version.epoch;
+    }
+    version.blocks.back()->nodes.push_back(make_shared<VersionedNode>(VersionedNode{version.epoch, nodeId, nodeLabel, 0, {}}));
+    version.id_to_index_mapping->emplace(nodeId, index);
+    version.numberNodes++;
+}
+
+void ConcurrentGraph::addDirectedEdge(int srcIndex, int destIndex, int edgeWeight) {
+    VersionedNode* node = mutableNode(srcIndex);
+    auto it = find_if(node->edgeList.begin(), node->edgeList.end(), [destIndex](const pair<int, int>& edge) {
+        return edge.first == destIndex;
+    });
+    if (it != node->edgeList.end()) {
+        it->second += edgeWeight;
+    } else {
+        node->edgeList.emplace_back(destIndex, edgeWeight);
+    }
+    node->degree += edgeWeight;
+}
+
+// Removes the entry by swapping the last one into its slot, returns removed weight
+int ConcurrentGraph::removeDirectedEdge(int srcIndex, int destIndex) {
+    VersionedNode* node = mutableNode(srcIndex);
+    auto it = find_if(node->edgeList.begin(), node->edgeList.end(), [destIndex](const pair<int, int>& edge) {
+        return edge.first == destIndex;
+    });
+    if (it == node->edgeList.end()) {
+        return 0;
+    }
+    int edgeWeight = it->second;
+    *it = node->edgeList.back();
+    node->edgeList.pop_back();
+    node->degree -= edgeWeight;
+    return edgeWeight;
+}
+
+void ConcurrentGraph::addUndirectedEdge(int srcNodeId, int destNodeId, int edgeWeight) {
+    if (edgeWeight == 0) {
+        return;
+    }
+    int srcIndex = getIndex(srcNodeId);
+    int destIndex = getIndex(destNodeId);
+    addDirectedEdge(srcIndex, destIndex, edgeWeight);
+    addDirectedEdge(destIndex, srcIndex, edgeWeight);
+    nextVersion().directedEdgeWeight += 2 * edgeWeight;
+}
+
+void ConcurrentGraph::removeUndirectedEdge(int srcNodeId, int destNodeId) {
+    int srcIndex = getIndex(srcNodeId);
+    int destIndex = getIndex(destNodeId);
+    int removedWeight = removeDirectedEdge(srcIndex, destIndex);
+    if (srcIndex != destIndex) {
+        removedWeight += removeDirectedEdge(destIndex, srcIndex);
+    }
+    nextVersion().directedEdgeWeight -= removedWeight;
+}
+
+void ConcurrentGraph::setLabel(int nodeId, int nodeLabel) {
+    mutableNode(getIndex(nodeId))->label = nodeLabel;
+}
+
+void ConcurrentGraph::apply(const EdgeEvent& event) {
+    if (event.op == EdgeOp::Add) {
+        addUndirectedEdge(event.src, event.dest);
+    } else if (event.op == EdgeOp::Remove) {
+        removeUndirectedEdge(event.src, event.dest);
+    } else {
+        throw runtime_error("Unknown edge event op code " + to_string(static_cast<int>(event.op)));
+    }
+}
+
+// Makes all changes since the last publish visible at once, returns the published epoch
+uint64_t ConcurrentGraph::publish() {
+    if (!pending) {
+        return atomic_load(&published)->epoch;
+    }
+    uint64_t epoch = pending->epoch;
+    atomic_store(&published, shared_ptr<const GraphVersion>(move(pending)));
+    pending.reset();
+    return epoch;
+}
+
+GraphSnapshot ConcurrentGraph::snapshot() const {
+    return GraphSnapshot(atomic_load(&published), blockSize);
+}
@@ -0,0 +1,96 @@
+#ifndef CONCURRENT_GRAPH_H
+#define CONCURRENT_GRAPH_H
+
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#include "graph.h"
+#include "edge_events.h"
+
+using namespace std;
+
+
+// Node state as of some epoch. Never modified once its epoch has been published.
+struct VersionedNode {
+    uint64_t epoch;
+    int id;
+    int label;
+    long long degree;
+    vector<pair<int, int>> edgeList; // {dense index of destination, weight}
+};
+
+// Fixed size group of consecutive dense indices, copied on the first write of an epoch
+struct NodeBlock {
+    uint64_t epoch;
+    vector<shared_ptr<VersionedNode>> nodes;
+};
+
+struct GraphVersion {
+    uint64_t epoch;
+    int numberNodes;
+    long long directedEdgeWeight;
+    vector<shared_ptr<NodeBlock>> blocks;
+    shared_ptr<unordered_map<int, int>> id_to_index_mapping; // shared until an epoch adds nodes
+};
+
+// Immutable view of one published version. Cheap to take and safe to read from any thread while the writer
+// keeps applying events.
+class GraphSnapshot {
+    public:
+        explicit GraphSnapshot(shared_ptr<const GraphVersion> version, size_t blockSize);
+
+        uint64_t getEpoch() const { return version->epoch; }
+        int numberNodes() const { return version->numberNodes; }
+        long long getTotalEdges() const { return version->directedEdgeWeight / 2; }
+        const VersionedNode& getNodeAt(int index) const;
+        const VersionedNode& getNode(int nodeId) const;
+        int getLabel(int nodeId) const { return getNode(nodeId).label; }
+        unordered_map<int, int> getLabels() const;
+        unordered_map<int, set<int>> getCommunities() const;
+        // Copies the snapshot into a Graph so the quality measures can run on it
+        Graph toGraph() const;
+
+    private:
+        shared_ptr<const GraphVersion> version;
+        size_t blockSize;
+};
+
+// Graph for one writer thread and any number of reader threads. The writer mutates a private next version, copying
+// only the blocks and nodes it touches, and publish() swaps it in atomically. Readers holding older snapshots keep
+// them alive until they let go.
+class ConcurrentGraph {
+    public:
+        static const size_t defaultBlockSize = 64;
+
+        explicit ConcurrentGraph(const Graph& graph, size_t blockSize = defaultBlockSize);
+        ~ConcurrentGraph();
+
+        // Writer side, changes become visible to readers on publish
+        void addNode(int nodeId, int nodeLabel);
+        void addUndirectedEdge(int srcNodeId, int destNodeId, int edgeWeight = 1);
+        void removeUndirectedEdge(int srcNodeId, int destNodeId);
+        void setLabel(int nodeId, int nodeLabel);
+        void apply(const EdgeEvent& event);
+        uint64_t publish();
+
+        // Reader side
+        GraphSnapshot snapshot() const;
+
+    private:
+        size_t blockSize;
+        shared_ptr<const GraphVersion> published; // accessed through atomic_load/atomic_store only
+        shared_ptr<GraphVersion> pending;         // writer's next version, null when nothing changed
+
+        GraphVersion& nextVersion();
+        int getIndex(int nodeId);
+        VersionedNode* mutableNode(int index);
+        void addDirectedEdge(int srcIndex, int destIndex, int edgeWeight);
+        int removeDirectedEdge(int srcIndex, int destIndex);
+};
+
+#endif // CONCURRENT_GRAPH_H
@@ -0,0 +1,192 @@
+#include "csr_graph.h"
+#include "mapped_file.h"
+
+#include <fstream>
+#include <climits>
+#include <cstring>
+
+
+namespace {
+    // Heap backing for snapshots built from a Graph
+    struct CsrArrays {
+        vector<int> offsets;
+        vector<int> neighbors;
+        vector<int> weights;
+        vector<int> ids;
+        vector<int> degrees;
+    };
+
+    const char binaryGraphMagic[4] = {'S', 'B', 'M', 'G'};
+}
+
+CsrGraph::CsrGraph(const Graph& graph): totalEdges(graph.getTotalEdges()) {
+    auto arrays = make_shared<CsrArrays>();
+    nodeCount = graph.nodes.size();
+    arrays->offsets.assign(nodeCount + 1, 0);
+    arrays->ids.reserve(nodeCount);
+    arrays->degrees.assign(nodeCount, 0);
+    labels.reserve(nodeCount);
+    id_to_index_mapping.reserve(nodeCount);
+
+    // Dense indices and row offsets
+    for (int i = 0; i < nodeCount; ++i) {
+        const Node* node = graph.nodes[i].get();
+        arrays->ids.push_back(node->id);
+        labels.push_back(node->label);
+        arrays->degrees[i] = node->degree;
+        id_to_index_mapping.emplace(node->id, i);
+        arrays->offsets[i + 1] = arrays->offsets[i] + node->edgeList.size();
+    }
+
+    // Contiguous neighbor and weight arrays
+    edgeEntryCount = arrays->offsets[nodeCount];
+    arrays->neighbors.resize(edgeEntryCount);
+    arrays->weights.resize(edgeEntryCount);
+    for (int i = 0; i < nodeCount; ++i) {
+        int position = arrays->offsets[i];
+        for (const auto& edge: graph.nodes[i]->edgeList) {
+            arrays->neighbors[position] = edge.first->getDenseIndex();
+            arrays->weights[position] = edge.second;
+            position++;
+        }
+    }
+
+    offsets = arrays->offsets.data();
+    neighbors = arrays->neighbors.data();
+    weights = arrays->weights.data();
+    ids = arrays->ids.data();
+    degrees = arrays->degrees.data();
+    storage = move(arrays);
+}
+
+CsrGraph::~CsrGraph() {
+    // Nothing to clean
+}
+
+int CsrGraph::numberNodes() const {
+    return nodeCount;
+}
+
+int CsrGraph::numberEdgeEntries() const {
+    return edgeEntryCount;
+}
+
+// Total edges includes weight as well
+long long CsrGraph::getTotalEdges() const {
+    return totalEdges;
+}
+
+int CsrGraph::getIndex(int nodeId) const {
+    auto it = id_to_index_mapping.find(nodeId);
+    if (it == id_to_index_mapping.end()) {
+        throw out_of_range("Node with id " + to_string(nodeId) + " not found in id to index mapping.");
+    }
+    return it->second;
+}
+
+CsrGraph CsrGraph::mapFile(const string& filepath) {
+    auto region = make_shared<MappedFile>(filepath);
+    size_t length = region->size();
+    if (length < sizeof(BinaryGraphHeader)) {
+        throw runtime_error("Binary graph file " + filepath + " is truncated");
+    }
+
+    const BinaryGraphHeader* header = reinterpret_cast<const BinaryGraphHeader*>(region->data());
+    if (memcmp(header->magic, binaryGraphMagic, sizeof(binaryGraphMagic)) != 0) {
+        throw runtime_error(filepath + " is not a binary graph file");
+    }
+    if (header->version != binaryVersion) {
+        throw runtime_error("Unsupported binary graph version " + to_string(header->version) + " in " + filepath);
+    }
+    if (header->numberNodes >= INT_MAX || header->numberEdgeEntries >= INT_MAX) {
+        throw runtime_error("Binary graph file " + filepath + " is too large");
+    }
+    size_t n = header->numberNodes;
+    size_t m = header->numberEdgeEntries;
+    if (length < sizeof(BinaryGraphHeader) + sizeof(int) * ((n + 1) + 3 * n + 2 * m)) {
+        throw runtime_error("Binary graph file " + filepath + " is truncated");
+    }
+
+    CsrGraph snapshot;
+    snapshot.nodeCount = n;
+    snapshot.edgeEntryCount = m;
+    snapshot.totalEdges = header->totalEdges;
+    const int* arrays = reinterpret_cast<const int*>(header + 1);
+    snapshot.offsets = arrays;
+    snapshot.ids = snapshot.offsets + n + 1;
+    const int* mappedLabels = snapshot.ids + n;
+    snapshot.degrees = mappedLabels + n;
+    snapshot.neighbors = snapshot.degrees + n;
+    snapshot.weights = snapshot.neighbors + m;
+    // Readers index nodes through offsets and neighbors without checks, so a corrupt file has to fail here
+    if (snapshot.offsets[0] != 0 || snapshot.offsets[n] != (int) m) {
+        throw runtime_error("Binary graph file " + filepath + " has inconsistent offsets");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (snapshot.offsets[i + 1] < snapshot.offsets[i]) {
+            throw runtime_error("Binary graph file " + filepath + " has inconsistent offsets");
+        }
+    }
+    for (size_t position = 0; position < m; ++position) {
+        if (snapshot.neighbors[position] < 0 || snapshot.neighbors[position] >= (int) n) {
+            throw runtime_error("Binary graph file " + filepath + " has neighbor " + to_string(snapshot.neighbors[position]) + " out of range");
+        }
+    }
+    // Degrees and the total are stored rather than recomputed, modularity is wrong if they disagree with the weights
+    long long directedEdgeWeight = 0;
+    for (size_t i = 0; i < n; ++i) {
+        long long degree = 0;
+        for (int position = snapshot.offsets[i]; position < snapshot.offsets[i + 1]; ++position) {
+            degree += snapshot.weights[position];
+        }
+        if (degree != snapshot.degrees[i]) {
+            throw runtime_error("Binary graph file " + filepath + " has degree " + to_string(snapshot.degrees[i]) + " for node " + to_string(snapshot.ids[i]) + " but its weights sum to " + to_string(degree));
+        }
+        directedEdgeWeight += degree;
+    }
+    // Same rounding as Graph::getTotalEdges
+    if (snapshot.totalEdges != directedEdgeWeight / 2) {
+        throw runtime_error("Binary graph file " + filepath + " has total edges " + to_string(snapshot.totalEdges) + " but its weights sum to " + to_string(directedEdgeWeight));
+    }
+    snapshot.storage = move(region);
+
+    // Labels are the only mutable array, copy them out of the mapping
+    snapshot.labels.assign(mappedLabels, mappedLabels + n);
+    snapshot.id_to_index_mapping.reserve(n);
+    for (int i = 0; i < (int) n; ++i) {
+        if (!snapshot.id_to_index_mapping.emplace(snapshot.ids[i], i).second) {
+            throw runtime_error("Binary graph file " + filepath + " repeats node id " + to_string(snapshot.ids[i]));
+        }
+    }
+
+    return snapshot;
+}
+
+void CsrGraph::writeFile(const string& filepath) const {
+    ofstream file(filepath, ios::binary | ios::trunc);
+    if (!file) {
+        throw runtime_error("Unable to open binary graph file " + filepath + " for writing");
+    }
+
+    BinaryGraphHeader header{};
+    memcpy(header.magic, binaryGraphMagic, sizeof(binaryGraphMagic));
+    header.version = binaryVersion;
+    header.numberNodes = nodeCount;
+    header.numberEdgeEntries = edgeEntryCount;
+    header.totalEdges = totalEdges;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    auto writeArray = [&file](const int* values, size_t count) {
+        file.write(reinterpret_cast<const char*>(values), sizeof(int) * count);
+    };
+    writeArray(offsets, nodeCount + 1);
+    writeArray(ids, nodeCount);
+    writeArray(labels.data(), nodeCount);
+    writeArray(degrees, nodeCount);
+    writeArray(neighbors, edgeEntryCount);
+    writeArray(weights, edgeEntryCount);
+
+    if (!file) {
+        throw runtime_error("Failed writing binary graph file " + filepath);
+    }
+}
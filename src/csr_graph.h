@@ -0,0 +1,79 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+#include "graph.h"
+
+using namespace std;
+
+
+// On-disk layout of a binary graph file: the header is followed by int32 arrays offsets[n + 1], ids[n],
+// labels[n], degrees[n], neighbors[m] and weights[m], all in host byte order.
+struct BinaryGraphHeader {
+    char magic[4];              // "SBMG"
+    uint32_t version;
+    uint64_t numberNodes;
+    uint64_t numberEdgeEntries;
+    int64_t totalEdges;
+};
+
+// Read-only compressed sparse row snapshot of a Graph. Nodes are addressed by dense indices 0..n-1 in the
+// order they appear in Graph::nodes; neighbors and weights of node i live in [offsets[i], offsets[i + 1]).
+// Topology is immutable after construction, labels are copied and may be updated by the caller.
+class CsrGraph {
+    public:
+        static const uint32_t binaryVersion = 1;
+
+        explicit CsrGraph(const Graph& graph);
+        ~CsrGraph();
+
+        // Maps a binary graph file read-only, topology arrays point straight into the mapping
+        static CsrGraph mapFile(const string& filepath);
+        void writeFile(const string& filepath) const;
+
+        int numberNodes() const;
+        int numberEdgeEntries() const;
+        long long getTotalEdges() const;
+        int getIndex(int nodeId) const;
+
+        int getId(int index) const { return ids[index]; }
+        int getLabel(int index) const { return labels[index]; }
+        void setLabel(int index, int label) { labels[index] = label; }
+        int getDegree(int index) const { return degrees[index]; }
+        int neighborBegin(int index) const { return offsets[index]; }
+        int neighborEnd(int index) const { return offsets[index + 1]; }
+        int getNeighbor(int position) const { return neighbors[position]; }
+        int getWeight(int position) const { return weights[position]; }
+
+        // Calls visit(neighborIndex, weight) for every neighbor, same traversal as CompressedCsrGraph
+        template <typename Visitor>
+        void forEachNeighbor(int index, Visitor&& visit) const {
+            for (int position = offsets[index]; position < offsets[index + 1]; ++position) {
+                visit(neighbors[position], weights[position]);
+            }
+        }
+
+    private:
+        CsrGraph() = default;
+
+        // Owns the topology arrays, either heap vectors or a file mapping. Shared so copies stay cheap.
+        shared_ptr<const void> storage;
+        int nodeCount = 0;
+        int edgeEntryCount = 0;
+        const int* offsets = nullptr;   // size n + 1
+        const int* neighbors = nullptr; // dense index of destination node
+        const int* weights = nullptr;
+        const int* ids = nullptr;
+        const int* degrees = nullptr;   // weighted degree
+        vector<int> labels;
+        long long totalEdges = 0;
+        unordered_map<int, int> id_to_index_mapping;
+};
+
+#endif // CSR_GRAPH_H
@@ -2,26 +2,44 @@
 
 
 DynamicCommunityDetection::DynamicCommunityDetection(
-    Graph graph,
+    const Graph& graph,
     int communityCount,
-    vector<pair<int, int>> addedEdges,
-    vector<pair<int, int>> removedEdges
+    const vector<pair<int, int>>& addedEdges,
+    const vector<pair<int, int>>& removedEdges,
+    NodeOrder nodeOrder
+): DynamicCommunityDetection(graph, communityCount, VectorEdgeStream(addedEdges, removedEdges), nodeOrder) {}
+
+DynamicCommunityDetection::DynamicCommunityDetection(
+    const Graph& graph,
+    int communityCount,
+    EdgeStream&& events,
+    NodeOrder nodeOrder
+): DynamicCommunityDetection(graph, communityCount, events, nodeOrder) {}
+
+DynamicCommunityDetection::DynamicCommunityDetection(
+    const Graph& graph,
+    int communityCount,
+    EdgeStream& events,
+    NodeOrder nodeOrder
 ):
     c_ll(graph),
     c_ul(Graph(0)),
     communityCount(communityCount),
     totalEdges(graph.getTotalEdges())
 {
+    c_ll.reorderNodes(nodeOrder);
+
     // Assign each node to its individual community
     for (auto& node: c_ll.nodes) {
-        node->label = node->id;
+        c_ll.setLabel(node.get(), node->id);
     }
 
     initialPartition(c_ll);
     Graph c_aux = c_ll;
     double mod = modularity(c_aux, totalEdges);
     double old_mod = 0.0;
-    int m = 0, n = 0;
+    EdgeEvent event;
+    bool pending = events.next(event);
     do {
         vector<pair<int, int>> changed_nodes = oneLevel(c_aux);
         updateCommunities(changed_nodes);
@@ -29,27 +47,24 @@ DynamicCommunityDetection::DynamicCommunityDetection(
         mod = modularity(c_ll, totalEdges);
         partitionToGraph();
 
-        if (m < addedEdges.size()) {
-            auto [src, dest] = addedEdges[m];
-            auto [involved_communities, anodes] = affectedByAddition(src, dest);
-            c_ll.addUndirectedEdge(src, dest);
+        if (pending && event.op == EdgeOp::Add) {
+            auto [involved_communities, anodes] = affectedByAddition(event.src, event.dest);
+            c_ll.addUndirectedEdge(event.src, event.dest);
             disbandCommunities(anodes);
             syncCommunities(involved_communities, anodes);
-            totalEdges++;
-            m++;
-        } else if (n < removedEdges.size()) {
-            auto [src, dest] = removedEdges[n];
-            auto [involved_communities, anodes] = affectedByRemoval(src, dest);
-            c_ll.removeUndirectedEdge(src, dest);
+            totalEdges = c_ll.getTotalEdges();
+        } else if (pending) {
+            auto [involved_communities, anodes] = affectedByRemoval(event.src, event.dest);
+            c_ll.removeUndirectedEdge(event.src, event.dest);
             disbandCommunities(anodes);
             syncCommunities(involved_communities, anodes);
-            // TODO: Need to subtract edgeWeight from totalEdges
-            totalEdges--;
-            n++;
+            totalEdges = c_ll.getTotalEdges();
         }
+        // Look one event ahead, so the loop stops right after the last one like it would for a fixed list
+        pending = pending && events.next(event);
 
         c_aux = c_ul;
-    } while (mod > old_mod || m < addedEdges.size() || n < removedEdges.size());
+    } while (mod > old_mod || pending);
 
     // Merge communities to expected number (Using Best Fit bin packing algorithm)
     // mergeCommunities(); // TODO: Disable merge algorithm
@@ -67,34 +82,38 @@ void DynamicCommunityDetection::initialPartition(Graph& auxiliary_graph) {
     }
     mt19937 g(rd());
 
+    // Topology doesn't change while moving nodes, so evaluate modularity on a contiguous snapshot
+    CsrGraph snapshot(auxiliary_graph);
+
     double initial_mod;
-    double new_mod = modularity(auxiliary_graph, totalEdges);
+    double new_mod = modularity(snapshot, totalEdges);
     do {
         shuffle(node_list.begin(), node_list.end(), g);
 
         for (auto& node: node_list) {
+            int index = snapshot.getIndex(node->id);
             int current_community = node->label;
             int best_community = current_community;
             double max_mod_gain = 0.0;
 
             // Fetch neighboring communities
             unordered_set<int> neighboring_communities;
-            for (const auto& edge: node->edgeList) {
-                const Node* neighbor = edge.first;
+            for (int position = snapshot.neighborBegin(index); position < snapshot.neighborEnd(index); ++position) {
+                int neighbor_community = snapshot.getLabel(snapshot.getNeighbor(position));
                 // Skip current community
-                if (neighbor->label != current_community) {
-                    neighboring_communities.insert(neighbor->label);
+                if (neighbor_community != current_community) {
+                    neighboring_communities.insert(neighbor_community);
                 }
             }
 
             // Find the community with highest modularity change
-            double old_mod = modularity(auxiliary_graph, totalEdges);
+            double old_mod = modularity(snapshot, totalEdges);
             for (int community: neighboring_communities) {
                 // Temp move to neighboring community
-                node->label = community;
+                snapshot.setLabel(index, community);
 
                 // Check modularity gain
-                double mod_gain = modularity(auxiliary_graph, totalEdges) - old_mod;
+                double mod_gain = modularity(snapshot, totalEdges) - old_mod;
 
                 // Note down the best community with highest modularity change
                 if (mod_gain > 0 && mod_gain > max_mod_gain) {
@@ -103,16 +122,17 @@ void DynamicCommunityDetection::initialPartition(Graph& auxiliary_graph) {
                 }
 
                 // Revert back to original community
-                node->label = current_community;
+                snapshot.setLabel(index, current_community);
             }
 
             // Move node to its best community
             if (current_community != best_community) {
-                node->label = best_community;
+                auxiliary_graph.setLabel(node, best_community);
+                snapshot.setLabel(index, best_community);
             }
         }
         initial_mod = new_mod;
-        new_mod = modularity(auxiliary_graph, totalEdges);
+        new_mod = modularity(snapshot, totalEdges);
     } while (new_mod > initial_mod);
 }
 
@@ -124,30 +144,32 @@ vector<pair<int, int>> DynamicCommunityDetection::oneLevel(Graph& auxiliary_grap
     mt19937 g(rd());
     shuffle(node_list.begin(), node_list.end(), g);
     vector<pair<int, int>> changed_nodes{};
+    CsrGraph snapshot(auxiliary_graph);
 
     for (auto& node: node_list) {
+        int index = snapshot.getIndex(node->id);
         int current_community = node->label;
         int best_community = current_community;
         double max_mod_gain = 0.0;
 
         // Fetch neighboring communities
         unordered_set<int> neighboring_communities;
-        for (const auto& edge: node->edgeList) {
-            const Node* neighbor = edge.first;
+        for (int position = snapshot.neighborBegin(index); position < snapshot.neighborEnd(index); ++position) {
+            int neighbor_community = snapshot.getLabel(snapshot.getNeighbor(position));
             // Skip current community
-            if (neighbor->label != current_community) {
-                neighboring_communities.insert(neighbor->label);
+            if (neighbor_community != current_community) {
+                neighboring_communities.insert(neighbor_community);
             }
         }
 
         // Find the community with highest modularity change
-        double old_mod = modularity(auxiliary_graph, totalEdges);
+        double old_mod = modularity(snapshot, totalEdges);
         for (int community: neighboring_communities) {
             // Temp move to neighboring community
-            node->label = community;
+            snapshot.setLabel(index, community);
 
             // Check modularity gain
-                double mod_gain = modularity(auxiliary_graph, totalEdges) - old_mod;
+            double mod_gain = modularity(snapshot, totalEdges) - old_mod;
 
             // Note down the best community with highest modularity change
             if (mod_gain > max(epsilon_gain, max_mod_gain)) {
@@ -156,12 +178,13 @@ vector<pair<int, int>> DynamicCommunityDetection::oneLevel(Graph& auxiliary_grap
             }
 
             // Revert back to original community
-            node->label = current_community;
+            snapshot.setLabel(index, current_community);
         }
 
         // Move node to its best community
         if (current_community != best_community) {
-            node->label = best_community;
+            auxiliary_graph.setLabel(node, best_community);
+            snapshot.setLabel(index, best_community);
             changed_nodes.emplace_back(node->id, best_community);
         }
     }
@@ -170,38 +193,28 @@ vector<pair<int, int>> DynamicCommunityDetection::oneLevel(Graph& auxiliary_grap
 }
 
 void DynamicCommunityDetection::updateCommunities(const vector<pair<int, int>>& changed_nodes) {
-    // List nodes as per communities
-    unordered_map<int, vector<Node*>> communities;
-    for (const auto& node: c_ll.nodes) {
-        communities[node->label].push_back(node.get());
+    // Collect members of every changed community before moving any of them
+    vector<vector<Node*>> members;
+    members.reserve(changed_nodes.size());
+    for (const auto& node_pair : changed_nodes) {
+        members.push_back(c_ll.getCommunity(node_pair.first));
     }
 
     // Move all grouped nodes to the new community
-    for (const auto& node_pair : changed_nodes) {
-        for (Node* node: communities.at(node_pair.first)) {
-            node->label = node_pair.second;
+    for (size_t i = 0; i < changed_nodes.size(); ++i) {
+        for (Node* node: members[i]) {
+            c_ll.setLabel(node, changed_nodes[i].second);
         }
     }
 }
 
 void DynamicCommunityDetection::partitionToGraph() {
-    unordered_map<int, vector<int>> communities;
-    for (const auto& node: c_ll.nodes) {
-        communities[node->label].push_back(node->id);
-    }
-
-    Graph partitioned_graph(communities.size());
-
-    // Update id, label, and mapping
-    int index = 0;
-    unordered_map<int, size_t> new_id_to_index_mapping;
-    for (const auto& community: communities) {
-        partitioned_graph.nodes[index]->id = community.first;
-        partitioned_graph.nodes[index]->label = community.first;
-        new_id_to_index_mapping.emplace(community.first, index);
-        index++;
+    // One node per community, with the community label as id and label
+    Graph partitioned_graph(0);
+    partitioned_graph.nodes.reserve(c_ll.numberCommunities());
+    for (const auto& community: c_ll.getCommunityMembers()) {
+        partitioned_graph.addNode(community.first, community.first);
     }
-    partitioned_graph.id_to_index_mapping = new_id_to_index_mapping;
 
     // Add edges
     for (const auto& node: c_ll.nodes) {
@@ -209,7 +222,7 @@ void DynamicCommunityDetection::partitionToGraph() {
         for (const auto& edge: node->edgeList) {
             int weight = edge.second;
             Node* destCommunity = partitioned_graph.getNode(edge.first->label);
-            srcCommunity->addEdge(destCommunity, weight);
+            partitioned_graph.addEdge(srcCommunity, destCommunity, weight);
         }
     }
 
@@ -227,10 +240,11 @@ pair<pair<Node*, Node*>, unordered_set<Node*>> DynamicCommunityDetection::affect
     Node* destCommunity = c_ll.getNode(destNode->label);
     pair<Node*, Node*> involved_communities = {srcCommunity, destCommunity};
 
-    for (const auto& node: c_ll.nodes) {
-        if (node->label == srcNode->label || node->label == destNode->label) {
-            affected_nodes.insert(node.get());
-        }
+    for (Node* node: c_ll.getCommunity(srcNode->label)) {
+        affected_nodes.insert(node);
+    }
+    for (Node* node: c_ll.getCommunity(destNode->label)) {
+        affected_nodes.insert(node);
     }
 
     return {involved_communities, affected_nodes};
@@ -242,7 +256,7 @@ pair<pair<Node*, Node*>, unordered_set<Node*>> DynamicCommunityDetection::affect
 
 void DynamicCommunityDetection::disbandCommunities(unordered_set<Node*>& anodes) {
     for (auto& node: anodes) {
-        node->label = node->id;
+        c_ll.setLabel(node, node->id);
     }
 }
 
@@ -267,7 +281,7 @@ void DynamicCommunityDetection::syncCommunities(pair<Node*, Node*>& involved_com
             if (anodes.find(dest) != anodes.end()) {
                 Node* c_ul_srcNode = c_ul.getNode(src->id);
                 Node* c_ul_destNode = c_ul.getNode(dest->label);
-                c_ul_srcNode->addEdge(c_ul_destNode, weight);
+                c_ul.addEdge(c_ul_srcNode, c_ul_destNode, weight);
             } else {
                 c_ul.addUndirectedEdge(src->id, dest->label, weight);
             }
@@ -347,10 +361,10 @@ void DynamicCommunityDetection::relabelGraph() {
     int index = 0;
     for (auto& node: c_ll.nodes) {
         try {
-            node->label = updated_label_map.at(node->label);
+            c_ll.setLabel(node.get(), updated_label_map.at(node->label));
         } catch (const out_of_range& e) {
             updated_label_map[node->label] = index;
-            node->label = index;
+            c_ll.setLabel(node.get(), index);
             index++;
         }
     }
@@ -0,0 +1,177 @@
+#include "dynamic_workload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+
+bool WorkloadConfig::isStatic() const {
+    return windowSize <= 0 && deleteRate <= 0.0 && departureRate <= 0.0 && arrivalRate <= 0.0 && initialActiveFraction >= 1.0;
+}
+
+WorkloadEdgeStream::WorkloadEdgeStream(Sbm& sbm, const WorkloadConfig& config):
+    sbm(sbm), config(config), gen(config.seed), additions(0), removals(0) {
+    for (double rate: {config.deleteRate, config.departureRate, config.arrivalRate}) {
+        if (rate < 0.0 || rate > 1.0) {
+            throw invalid_argument("Workload rates must lie in [0, 1]");
+        }
+    }
+    if (config.deleteRate == 1.0) {
+        throw invalid_argument("Workload delete rate must be below 1, otherwise no edge is ever added");
+    }
+    if (config.initialActiveFraction <= 0.0 || config.initialActiveFraction > 1.0) {
+        throw invalid_argument("Workload initial active fraction must lie in (0, 1]");
+    }
+
+    int numberNodes = sbm.sbm_graph.nodes.size();
+    liveNeighbors.resize(numberNodes);
+    nodePosition.resize(numberNodes);
+    active.assign(numberNodes, 0);
+
+    // A random subset of nodes starts active, at least two so the first edge can be drawn
+    vector<int> order(numberNodes);
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), gen);
+    int initialActive = max(min(2, numberNodes), (int)llround(config.initialActiveFraction * numberNodes));
+    for (int i = 0; i < numberNodes; ++i) {
+        vector<int>& nodes = (i < initialActive) ? activeNodes : inactiveNodes;
+        active[order[i]] = (i < initialActive);
+        nodePosition[order[i]] = nodes.size();
+        nodes.push_back(order[i]);
+    }
+}
+
+bool WorkloadEdgeStream::next(EdgeEvent& event) {
+    // Finish the removals owed by a departed node first
+    if (!departingEdges.empty()) {
+        auto [src, dest] = departingEdges.front();
+        departingEdges.pop_front();
+        removeLiveEdge(edgeKey(src, dest), event);
+        return true;
+    }
+    if (expireOldest(event)) {
+        return true;
+    }
+    if (additions >= config.numberAdditions) {
+        return false;
+    }
+
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    if (!inactiveNodes.empty() && unit(gen) < config.arrivalRate) {
+        setActive(inactiveNodes[randomIndex(inactiveNodes.size())], true);
+    }
+    if (activeNodes.size() > 2 && unit(gen) < config.departureRate) {
+        int nodeId = activeNodes[randomIndex(activeNodes.size())];
+        setActive(nodeId, false);
+        for (int neighborId: liveNeighbors[nodeId]) {
+            departingEdges.push_back({nodeId, neighborId});
+        }
+        if (!departingEdges.empty()) {
+            return next(event);
+        }
+    }
+    if (!liveEdges.empty() && unit(gen) < config.deleteRate) {
+        const LiveEdge& edge = liveEdges[randomIndex(liveEdges.size())];
+        removeLiveEdge(edgeKey(edge.src, edge.dest), event);
+        return true;
+    }
+
+    pair<int, int> edge;
+    if (drawEdge(edge)) {
+        addLiveEdge(edge.first, edge.second, event);
+        return true;
+    }
+    // Active nodes are (nearly) saturated, make room instead
+    if (liveEdges.empty()) {
+        throw runtime_error("Workload could not draw an edge between active nodes");
+    }
+    const LiveEdge& victim = liveEdges[randomIndex(liveEdges.size())];
+    removeLiveEdge(edgeKey(victim.src, victim.dest), event);
+    return true;
+}
+
+uint64_t WorkloadEdgeStream::edgeKey(int src, int dest) {
+    if (src > dest) {
+        swap(src, dest);
+    }
+    return (uint64_t(uint32_t(src)) << 32) | uint32_t(dest);
+}
+
+size_t WorkloadEdgeStream::randomIndex(size_t size) {
+    return uniform_int_distribution<size_t>(0, size - 1)(gen);
+}
+
+pair<int, int> WorkloadEdgeStream::sampleEdge() {
+    return sbm.generateEdge();
+}
+
+bool WorkloadEdgeStream::drawEdge(pair<int, int>& edge) {
+    // Rejection against inactive endpoints and live duplicates, bounded so dense corners can't stall the stream
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        edge = sampleEdge();
+        if (edge.first != edge.second && active[edge.first] && active[edge.second]
+            && livePosition.count(edgeKey(edge.first, edge.second)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkloadEdgeStream::addLiveEdge(int src, int dest, EdgeEvent& event) {
+    uint64_t key = edgeKey(src, dest);
+    livePosition.emplace(key, liveEdges.size());
+    liveEdges.push_back({src, dest, additions});
+    liveNeighbors[src].insert(dest);
+    liveNeighbors[dest].insert(src);
+    if (config.windowSize > 0) {
+        arrivalOrder.push_back({key, additions});
+    }
+    additions++;
+    event = {src, dest, EdgeOp::Add, {}};
+}
+
+void WorkloadEdgeStream::removeLiveEdge(uint64_t key, EdgeEvent& event) {
+    size_t slot = livePosition.at(key);
+    LiveEdge edge = liveEdges[slot];
+    if (slot != liveEdges.size() - 1) {
+        liveEdges[slot] = liveEdges.back();
+        livePosition[edgeKey(liveEdges[slot].src, liveEdges[slot].dest)] = slot;
+    }
+    liveEdges.pop_back();
+    livePosition.erase(key);
+    liveNeighbors[edge.src].erase(edge.dest);
+    liveNeighbors[edge.dest].erase(edge.src);
+    removals++;
+    event = {edge.src, edge.dest, EdgeOp::Remove, {}};
+}
+
+void WorkloadEdgeStream::setActive(int nodeId, bool isActive) {
+    vector<int>& from = isActive ? inactiveNodes : activeNodes;
+    vector<int>& to = isActive ? activeNodes : inactiveNodes;
+    size_t slot = nodePosition[nodeId];
+    from[slot] = from.back();
+    nodePosition[from[slot]] = slot;
+    from.pop_back();
+    nodePosition[nodeId] = to.size();
+    to.push_back(nodeId);
+    active[nodeId] = isActive;
+}
+
+bool WorkloadEdgeStream::expireOldest(EdgeEvent& event) {
+    while (!arrivalOrder.empty()) {
+        auto [key, addedAt] = arrivalOrder.front();
+        auto it = livePosition.find(key);
+        // Removed by churn or a departure, possibly added again since
+        if (it == livePosition.end() || liveEdges[it->second].addedAt != addedAt) {
+            arrivalOrder.pop_front();
+            continue;
+        }
+        if (additions - addedAt < config.windowSize) {
+            return false;
+        }
+        arrivalOrder.pop_front();
+        removeLiveEdge(key, event);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,86 @@
+#ifndef DYNAMIC_WORKLOAD_H
+#define DYNAMIC_WORKLOAD_H
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <random>
+#include <cstdint>
+#include <stdexcept>
+
+#include "edge_stream.h"
+#include "sbm.h"
+
+using namespace std;
+
+
+// Shape of a dynamic workload. Rates are probabilities per step, all zero gives a plain stream of additions.
+struct WorkloadConfig {
+    long long numberAdditions = 0;
+    // Edges expire this many additions after they were added, 0 keeps them until churn removes them. Expiries come on
+    // top of the removals from deleteRate.
+    long long windowSize = 0;
+    // Chance that a step removes a random live edge instead of adding one. Without a window and departures, 0.3 gives
+    // roughly 30% removals among all events.
+    double deleteRate = 0.0;
+    // Chance that a step lets an active node leave, removing all of its live edges
+    double departureRate = 0.0;
+    // Chance that a step lets an inactive node join, after which it gets edges again
+    double arrivalRate = 0.0;
+    // Fraction of nodes active at the start, the others arrive over time
+    double initialActiveFraction = 1.0;
+    uint64_t seed = 0;
+
+    bool isStatic() const;
+};
+
+// Interleaved additions and removals over an Sbm. Edges are drawn from the Sbm between active nodes, expire out of
+// the sliding window, get removed by random churn, or leave together with a departing node. A live edge is never
+// added twice, so every removal hits an edge that is present.
+class WorkloadEdgeStream: public EdgeStream {
+    public:
+        WorkloadEdgeStream(Sbm& sbm, const WorkloadConfig& config);
+        bool next(EdgeEvent& event) override;
+
+        long long numberAdditions() const { return additions; }
+        long long numberRemovals() const { return removals; }
+        size_t numberLiveEdges() const { return liveEdges.size(); }
+        size_t numberActiveNodes() const { return activeNodes.size(); }
+
+    protected:
+        // Candidate edge for the next addition, may be rejected and drawn again
+        virtual pair<int, int> sampleEdge();
+
+    private:
+        struct LiveEdge {
+            int src;
+            int dest;
+            long long addedAt;
+        };
+
+        Sbm& sbm;
+        WorkloadConfig config;
+        mt19937_64 gen;
+        long long additions;
+        long long removals;
+        vector<LiveEdge> liveEdges;
+        unordered_map<uint64_t, size_t> livePosition;   // edge key to slot in liveEdges
+        deque<pair<uint64_t, long long>> arrivalOrder;  // {edge key, addedAt} for the window, stale entries are skipped
+        vector<unordered_set<int>> liveNeighbors;
+        vector<int> activeNodes;
+        vector<int> inactiveNodes;
+        vector<size_t> nodePosition;                    // slot in activeNodes or inactiveNodes
+        vector<char> active;
+        deque<pair<int, int>> departingEdges;            // removals still owed by nodes that left
+
+        static uint64_t edgeKey(int src, int dest);
+        size_t randomIndex(size_t size);
+        bool drawEdge(pair<int, int>& edge);
+        void addLiveEdge(int src, int dest, EdgeEvent& event);
+        void removeLiveEdge(uint64_t key, EdgeEvent& event);
+        void setActive(int nodeId, bool isActive);
+        bool expireOldest(EdgeEvent& event);
+};
+
+#endif // DYNAMIC_WORKLOAD_H
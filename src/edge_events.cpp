@@ -0,0 +1,101 @@
+#include "edge_events.h"
+
+#include <cstring>
+#include <filesystem>
+
+
+namespace {
+    const char edgeEventMagic[4] = {'S', 'B', 'M', 'E'};
+}
+
+EdgeEventWriter::EdgeEventWriter(const string& filepath): filepath(filepath) {
+    bool newFile = !filesystem::exists(filepath) || filesystem::file_size(filepath) == 0;
+    if (!newFile) {
+        // Refuse to append to something that is not an edge event file of this version
+        size_t completeSize;
+        {
+            MappedEdgeEvents existing(filepath);
+            completeSize = sizeof(EdgeEventHeader) + existing.size() * sizeof(EdgeEvent);
+        }
+        // Drop a partial record left by an interrupted writer, appending after it would misalign every later record
+        if (filesystem::file_size(filepath) != completeSize) {
+            filesystem::resize_file(filepath, completeSize);
+        }
+    }
+
+    file.open(filepath, ios::binary | ios::app);
+    if (!file) {
+        throw runtime_error("Unable to open edge event file " + filepath + " for writing");
+    }
+    if (newFile) {
+        EdgeEventHeader header{};
+        memcpy(header.magic, edgeEventMagic, sizeof(edgeEventMagic));
+        header.version = binaryVersion;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+}
+
+EdgeEventWriter::~EdgeEventWriter() {
+    file.flush();
+}
+
+void EdgeEventWriter::append(int srcNodeId, int destNodeId, EdgeOp op) {
+    EdgeEvent event{};
+    event.src = srcNodeId;
+    event.dest = destNodeId;
+    event.op = op;
+    file.write(reinterpret_cast<const char*>(&event), sizeof(event));
+}
+
+void EdgeEventWriter::append(const vector<pair<int, int>>& edges, EdgeOp op) {
+    for (const auto& edge: edges) {
+        append(edge.first, edge.second, op);
+    }
+}
+
+void EdgeEventWriter::flush() {
+    file.flush();
+    if (!file) {
+        throw runtime_error("Failed writing edge event file " + filepath);
+    }
+}
+
+MappedEdgeEvents::MappedEdgeEvents(const string& filepath):
+    region(make_unique<MappedFile>(filepath)), events(nullptr), count(0) {
+    if (region->size() < sizeof(EdgeEventHeader)) {
+        throw runtime_error("Edge event file " + filepath + " is truncated");
+    }
+
+    const EdgeEventHeader* header = reinterpret_cast<const EdgeEventHeader*>(region->data());
+    if (memcmp(header->magic, edgeEventMagic, sizeof(edgeEventMagic)) != 0) {
+        throw runtime_error(filepath + " is not an edge event file");
+    }
+    if (header->version != EdgeEventWriter::binaryVersion) {
+        throw runtime_error("Unsupported edge event version " + to_string(header->version) + " in " + filepath);
+    }
+
+    events = reinterpret_cast<const EdgeEvent*>(header + 1);
+    count = (region->size() - sizeof(EdgeEventHeader)) / sizeof(EdgeEvent);
+}
+
+MappedEdgeEvents::~MappedEdgeEvents() {
+    // Nothing to clean
+}
+
+void MappedEdgeEvents::split(vector<pair<int, int>>& addedEdges, vector<pair<int, int>>& removedEdges) const {
+    for (const EdgeEvent& event: *this) {
+        if (event.op == EdgeOp::Add) {
+            addedEdges.emplace_back(event.src, event.dest);
+        } else if (event.op == EdgeOp::Remove) {
+            removedEdges.emplace_back(event.src, event.dest);
+        } else {
+            throw runtime_error("Unknown edge event op code " + to_string(static_cast<int>(event.op)));
+        }
+    }
+}
+
+bool isEdgeEventFile(const string& filepath) {
+    ifstream file(filepath, ios::binary);
+    char magic[sizeof(edgeEventMagic)];
+    return file.read(magic, sizeof(magic)) && memcmp(magic, edgeEventMagic, sizeof(magic)) == 0;
+}
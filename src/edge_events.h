@@ -0,0 +1,72 @@
+#ifndef EDGE_EVENTS_H
+#define EDGE_EVENTS_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+using namespace std;
+
+
+enum class EdgeOp : uint8_t { Add = 0, Remove = 1 };
+
+// Fixed size record of an edge event file. The file is an EdgeEventHeader followed by back to back records,
+// a trailing partial record left by an interrupted writer is ignored by readers.
+struct EdgeEvent {
+    int32_t src;
+    int32_t dest;
+    EdgeOp op;
+    uint8_t padding[3];
+};
+
+struct EdgeEventHeader {
+    char magic[4];      // "SBME"
+    uint32_t version;
+};
+
+// Appends edge events to a file, creating it with a header when it does not exist yet
+class EdgeEventWriter {
+    public:
+        static const uint32_t binaryVersion = 1;
+
+        explicit EdgeEventWriter(const string& filepath);
+        ~EdgeEventWriter();
+
+        void append(int srcNodeId, int destNodeId, EdgeOp op);
+        void append(const vector<pair<int, int>>& edges, EdgeOp op);
+        void flush();
+
+    private:
+        ofstream file;
+        string filepath;
+};
+
+// Read-only view of an edge event file, records are read straight from the mapping
+class MappedEdgeEvents {
+    public:
+        explicit MappedEdgeEvents(const string& filepath);
+        ~MappedEdgeEvents();
+
+        size_t size() const { return count; }
+        const EdgeEvent& operator[](size_t position) const { return events[position]; }
+        const EdgeEvent* begin() const { return events; }
+        const EdgeEvent* end() const { return events + count; }
+
+        // Splits events into the added and removed edge lists taken by the algorithm constructors
+        void split(vector<pair<int, int>>& addedEdges, vector<pair<int, int>>& removedEdges) const;
+
+    private:
+        unique_ptr<MappedFile> region;
+        const EdgeEvent* events;
+        size_t count;
+};
+
+// True if the file starts with the edge event magic
+bool isEdgeEventFile(const string& filepath);
+
+#endif // EDGE_EVENTS_H
@@ -0,0 +1,108 @@
+#include "edge_stream.h"
+
+#include <iostream>
+#include <sstream>
+
+
+EdgeStream::~EdgeStream() {
+    // Nothing to clean
+}
+
+VectorEdgeStream::VectorEdgeStream(const vector<pair<int, int>>& addedEdges, const vector<pair<int, int>>& removedEdges):
+    addedEdges(addedEdges), removedEdges(removedEdges), position(0) {}
+
+bool VectorEdgeStream::next(EdgeEvent& event) {
+    if (position < addedEdges.size()) {
+        event = {addedEdges[position].first, addedEdges[position].second, EdgeOp::Add, {}};
+    } else if (position < addedEdges.size() + removedEdges.size()) {
+        const auto& edge = removedEdges[position - addedEdges.size()];
+        event = {edge.first, edge.second, EdgeOp::Remove, {}};
+    } else {
+        return false;
+    }
+    position++;
+    return true;
+}
+
+TextEdgeStream::TextEdgeStream(istream& input): input(input), lineNumber(0) {}
+
+TextEdgeStream::TextEdgeStream(const string& filepath):
+    file(make_unique<ifstream>(filepath)), input(*file), lineNumber(0) {
+    if (!*file) {
+        throw runtime_error("Unable to open edge file " + filepath);
+    }
+}
+
+bool TextEdgeStream::next(EdgeEvent& event) {
+    while (getline(input, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == string::npos || line[start] == '#') {
+            continue;
+        }
+
+        EdgeOp op = EdgeOp::Add;
+        if (line[start] == '+' || line[start] == '-') {
+            op = (line[start] == '+') ? EdgeOp::Add : EdgeOp::Remove;
+            start++;
+        }
+        istringstream fields(line.substr(start));
+        if (!(fields >> event.src >> event.dest)) {
+            throw runtime_error("Malformed edge event on line " + to_string(lineNumber) + ": " + line);
+        }
+        event.op = op;
+        return true;
+    }
+    return false;
+}
+
+MappedEdgeStream::MappedEdgeStream(const string& filepath): events(filepath), position(0) {}
+
+bool MappedEdgeStream::next(EdgeEvent& event) {
+    if (position == events.size()) {
+        return false;
+    }
+    event = events[position++];
+    if (event.op != EdgeOp::Add && event.op != EdgeOp::Remove) {
+        throw runtime_error("Unknown edge event op code " + to_string(static_cast<int>(event.op)));
+    }
+    return true;
+}
+
+SbmEdgeStream::SbmEdgeStream(Sbm& sbm, long long numberEdges): sbm(sbm), remaining(numberEdges) {}
+
+bool SbmEdgeStream::next(EdgeEvent& event) {
+    if (remaining <= 0) {
+        return false;
+    }
+    remaining--;
+    auto [src, dest] = sbm.generateEdge();
+    event = {src, dest, EdgeOp::Add, {}};
+    return true;
+}
+
+SbmInstanceStream::SbmInstanceStream(const Sbm& sbm): sbm(sbm), chunkIndex(0), position(0) {}
+
+bool SbmInstanceStream::next(EdgeEvent& event) {
+    while (position == chunkEdges.size()) {
+        if (chunkIndex == sbm.numberSamplingChunks()) {
+            return false;
+        }
+        chunkEdges.clear();
+        position = 0;
+        sbm.generateChunkEdges(chunkIndex++, chunkEdges);
+    }
+    event = {chunkEdges[position].first, chunkEdges[position].second, EdgeOp::Add, {}};
+    position++;
+    return true;
+}
+
+unique_ptr<EdgeStream> openEdgeStream(const string& path) {
+    if (path == "-") {
+        return make_unique<TextEdgeStream>(cin);
+    }
+    if (isEdgeEventFile(path)) {
+        return make_unique<MappedEdgeStream>(path);
+    }
+    return make_unique<TextEdgeStream>(path);
+}
@@ -0,0 +1,92 @@
+#ifndef EDGE_STREAM_H
+#define EDGE_STREAM_H
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+#include "edge_events.h"
+#include "sbm.h"
+
+using namespace std;
+
+
+// Pull based source of edge events. The algorithms take events one at a time, so no stream has to be held in memory
+// as a whole.
+class EdgeStream {
+    public:
+        virtual ~EdgeStream();
+        // Fills event and returns true, or returns false once the stream is exhausted
+        virtual bool next(EdgeEvent& event) = 0;
+};
+
+// Added edges followed by removed edges of two lists that outlive the stream
+class VectorEdgeStream: public EdgeStream {
+    public:
+        VectorEdgeStream(const vector<pair<int, int>>& addedEdges, const vector<pair<int, int>>& removedEdges);
+        bool next(EdgeEvent& event) override;
+
+    private:
+        const vector<pair<int, int>>& addedEdges;
+        const vector<pair<int, int>>& removedEdges;
+        size_t position;
+};
+
+// One event per line: "src dest" or "+ src dest" adds an edge, "- src dest" removes it. Blank lines and lines
+// starting with # are skipped.
+class TextEdgeStream: public EdgeStream {
+    public:
+        // Reads from a stream owned by the caller, for example cin
+        explicit TextEdgeStream(istream& input);
+        explicit TextEdgeStream(const string& filepath);
+        bool next(EdgeEvent& event) override;
+
+    private:
+        unique_ptr<ifstream> file;
+        istream& input;
+        string line;
+        long long lineNumber;
+};
+
+// Records of a binary edge event file, read from the mapping in file order
+class MappedEdgeStream: public EdgeStream {
+    public:
+        explicit MappedEdgeStream(const string& filepath);
+        bool next(EdgeEvent& event) override;
+
+    private:
+        MappedEdgeEvents events;
+        size_t position;
+};
+
+// numberEdges additions drawn one at a time from Sbm::generateEdge
+class SbmEdgeStream: public EdgeStream {
+    public:
+        SbmEdgeStream(Sbm& sbm, long long numberEdges);
+        bool next(EdgeEvent& event) override;
+
+    private:
+        Sbm& sbm;
+        long long remaining;
+};
+
+// Every edge of the full instance of an Sbm as additions, generated one sampling chunk at a time
+class SbmInstanceStream: public EdgeStream {
+    public:
+        explicit SbmInstanceStream(const Sbm& sbm);
+        bool next(EdgeEvent& event) override;
+
+    private:
+        const Sbm& sbm;
+        size_t chunkIndex;
+        vector<pair<int, int>> chunkEdges;
+        size_t position;
+};
+
+// Opens a binary edge event file, or a text file when the edge event magic is missing. "-" reads text from stdin.
+unique_ptr<EdgeStream> openEdgeStream(const string& path);
+
+#endif // EDGE_STREAM_H
@@ -0,0 +1,336 @@
+#include "evolving_sbm.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <limits>
+#include <cstring>
+
+
+namespace {
+    const char partitionCheckpointMagic[4] = {'S', 'B', 'M', 'P'};
+}
+
+PartitionCheckpointWriter::PartitionCheckpointWriter(const string& filepath, int numberNodes):
+    filepath(filepath), previous(numberNodes, -1) {
+    file.open(filepath, ios::binary | ios::trunc);
+    if (!file) {
+        throw runtime_error("Unable to open partition checkpoint file " + filepath + " for writing");
+    }
+    PartitionCheckpointHeader header{};
+    memcpy(header.magic, partitionCheckpointMagic, sizeof(partitionCheckpointMagic));
+    header.version = binaryVersion;
+    header.numberNodes = numberNodes;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+PartitionCheckpointWriter::~PartitionCheckpointWriter() {
+    file.flush();
+}
+
+void PartitionCheckpointWriter::write(long long position, const vector<int>& communities) {
+    if (communities.size() != previous.size()) {
+        throw invalid_argument("Checkpoint partition has " + to_string(communities.size()) + " nodes, expected "
+                               + to_string(previous.size()));
+    }
+
+    vector<int32_t> changed;
+    for (size_t nodeId = 0; nodeId < communities.size(); ++nodeId) {
+        if (communities[nodeId] != previous[nodeId]) {
+            changed.push_back(nodeId);
+            changed.push_back(communities[nodeId]);
+        }
+    }
+    previous = communities;
+
+    int64_t recordPosition = position;
+    uint32_t count = changed.size() / 2;
+    file.write(reinterpret_cast<const char*>(&recordPosition), sizeof(recordPosition));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(changed.data()), changed.size() * sizeof(int32_t));
+    file.flush();
+    if (!file) {
+        throw runtime_error("Failed writing partition checkpoint file " + filepath);
+    }
+}
+
+vector<pair<long long, vector<int>>> readPartitionCheckpoints(const string& filepath) {
+    ifstream file(filepath, ios::binary);
+    if (!file) {
+        throw runtime_error("Unable to open partition checkpoint file " + filepath);
+    }
+
+    PartitionCheckpointHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        throw runtime_error("Partition checkpoint file " + filepath + " is truncated");
+    }
+    if (memcmp(header.magic, partitionCheckpointMagic, sizeof(partitionCheckpointMagic)) != 0) {
+        throw runtime_error(filepath + " is not a partition checkpoint file");
+    }
+    if (header.version != PartitionCheckpointWriter::binaryVersion) {
+        throw runtime_error("Unsupported partition checkpoint version " + to_string(header.version) + " in " + filepath);
+    }
+
+    vector<pair<long long, vector<int>>> checkpoints;
+    vector<int> current(header.numberNodes, -1);
+    int64_t position;
+    uint32_t count;
+    // A trailing partial record left by an interrupted writer is ignored
+    while (file.read(reinterpret_cast<char*>(&position), sizeof(position))
+           && file.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        vector<int32_t> changed(2 * size_t(count));
+        if (!file.read(reinterpret_cast<char*>(changed.data()), changed.size() * sizeof(int32_t))) {
+            break;
+        }
+        for (size_t i = 0; i < changed.size(); i += 2) {
+            if (changed[i] < 0 || changed[i] >= header.numberNodes) {
+                throw runtime_error("Node " + to_string(changed[i]) + " out of range in " + filepath);
+            }
+            current[changed[i]] = changed[i + 1];
+        }
+        checkpoints.emplace_back(position, current);
+    }
+    return checkpoints;
+}
+
+EvolvingSbmStream::EvolvingSbmStream(Sbm& sbm, const WorkloadConfig& workload, const EvolutionConfig& evolution):
+    WorkloadEdgeStream(sbm, workload),
+    evolution(evolution),
+    nextChange(0),
+    // Separate from the workload's own stream
+    gen(workload.seed ^ 0x9e3779b97f4a7c15ULL),
+    startIntra(sbm.intraCommunityEdgeProbability),
+    startInter(sbm.interCommunityEdgeProbability),
+    targetIntra(sbm.intraCommunityEdgeProbability),
+    targetInter(sbm.interCommunityEdgeProbability),
+    driftStart(0),
+    driftDuration(0),
+    nextCheckpoint(numeric_limits<long long>::max())
+{
+    int numberNodes = sbm.sbm_graph.nodes.size();
+    community.assign(numberNodes, -1);
+    memberPosition.resize(numberNodes);
+
+    // Blocks keep their planted label as community id, so planted changes and the ground truth use the labels of
+    // sbm_graph. Nodes left over outside the blocks get fresh ids after them.
+    members.resize(sbm.numberCommunities);
+    unordered_map<int, int> leftover_communities;
+    for (const auto& node: sbm.sbm_graph.nodes) {
+        if (node->id < 0 || node->id >= numberNodes) {
+            throw runtime_error("Evolving SBM expects node ids 0 to " + to_string(numberNodes - 1));
+        }
+        int id = node->label;
+        if (id < 0 || id >= sbm.numberCommunities) {
+            auto [it, inserted] = leftover_communities.emplace(node->label, members.size());
+            if (inserted) {
+                members.emplace_back();
+            }
+            id = it->second;
+        }
+        community[node->id] = id;
+        memberPosition[node->id] = members[id].size();
+        members[id].push_back(node->id);
+    }
+    totalPairs = (long long)numberNodes * (numberNodes - 1) / 2;
+    updatePairWeights();
+
+    stable_sort(this->evolution.changes.begin(), this->evolution.changes.end(),
+        [](const PlantedChange& a, const PlantedChange& b) { return a.at < b.at; });
+    validateChanges();
+
+    if (!evolution.checkpointPath.empty()) {
+        checkpoints = make_unique<PartitionCheckpointWriter>(evolution.checkpointPath, numberNodes);
+        writeCheckpoint();
+        if (evolution.checkpointInterval > 0) {
+            nextCheckpoint = evolution.checkpointInterval;
+        }
+    }
+}
+
+bool EvolvingSbmStream::next(EdgeEvent& event) {
+    bool changed = false;
+    while (nextChange < evolution.changes.size() && evolution.changes[nextChange].at <= numberAdditions()) {
+        applyChange(evolution.changes[nextChange++]);
+        changed = true;
+    }
+    if (checkpoints && (changed || position() >= nextCheckpoint)) {
+        writeCheckpoint();
+        while (nextCheckpoint <= position()) {
+            nextCheckpoint += evolution.checkpointInterval;
+        }
+    }
+    return WorkloadEdgeStream::next(event);
+}
+
+double EvolvingSbmStream::currentIntraCommunityEdgeProbability() const {
+    long long elapsed = numberAdditions() - driftStart;
+    if (elapsed >= driftDuration) {
+        return targetIntra;
+    }
+    return startIntra + (targetIntra - startIntra) * elapsed / driftDuration;
+}
+
+double EvolvingSbmStream::currentInterCommunityEdgeProbability() const {
+    long long elapsed = numberAdditions() - driftStart;
+    if (elapsed >= driftDuration) {
+        return targetInter;
+    }
+    return startInter + (targetInter - startInter) * elapsed / driftDuration;
+}
+
+pair<int, int> EvolvingSbmStream::sampleEdge() {
+    // Same model as the Sbm: pick intra or inter by total probability mass, then a uniform pair within it
+    double intraMass = currentIntraCommunityEdgeProbability() * intraPairs;
+    double interMass = currentInterCommunityEdgeProbability() * (totalPairs - intraPairs);
+    if (intraMass + interMass <= 0.0) {
+        throw runtime_error("Evolving SBM has no edge left to draw, p and q are both zero");
+    }
+
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    if (unit(gen) * (intraMass + interMass) < intraMass) {
+        double pairWeight = unit(gen) * intraPairWeights.back();
+        size_t target = upper_bound(intraPairWeights.begin(), intraPairWeights.end(), pairWeight) - intraPairWeights.begin();
+        const vector<int>& nodes = members[min(target, members.size() - 1)];
+        uniform_int_distribution<size_t> pick(0, nodes.size() - 1);
+        size_t first = pick(gen);
+        size_t second = pick(gen);
+        while (second == first) {
+            second = pick(gen);
+        }
+        return {nodes[first], nodes[second]};
+    }
+
+    uniform_int_distribution<int> pick(0, community.size() - 1);
+    while (true) {
+        int first = pick(gen);
+        int second = pick(gen);
+        if (community[first] != community[second]) {
+            return {first, second};
+        }
+    }
+}
+
+void EvolvingSbmStream::moveNode(int nodeId, int target) {
+    vector<int>& from = members[community[nodeId]];
+    size_t slot = memberPosition[nodeId];
+    from[slot] = from.back();
+    memberPosition[from[slot]] = slot;
+    from.pop_back();
+
+    memberPosition[nodeId] = members[target].size();
+    members[target].push_back(nodeId);
+    community[nodeId] = target;
+}
+
+void EvolvingSbmStream::validateChanges() const {
+    // Replays which communities exist along the schedule, so a bad config fails here instead of partway through the
+    // stream. Migrations never empty a community and the split of a single node community leaves the new one empty,
+    // which only applyChange can tell.
+    vector<bool> exists(members.size());
+    for (size_t id = 0; id < members.size(); ++id) {
+        exists[id] = !members[id].empty();
+    }
+    auto checkCommunity = [&](const PlantedChange& change, int id) {
+        if (id < 0 || id >= int(exists.size()) || !exists[id]) {
+            throw out_of_range("Planted change at " + to_string(change.at) + " refers to missing community " + to_string(id));
+        }
+    };
+
+    for (const PlantedChange& change: evolution.changes) {
+        switch (change.type) {
+            case CommunityChange::Merge:
+                checkCommunity(change, change.community);
+                checkCommunity(change, change.target);
+                if (change.community == change.target) {
+                    throw invalid_argument("Planted merge at " + to_string(change.at) + " merges a community into itself");
+                }
+                exists[change.community] = false;
+                break;
+            case CommunityChange::Split:
+                checkCommunity(change, change.community);
+                exists.push_back(true);
+                break;
+            case CommunityChange::Migrate:
+            case CommunityChange::Drift:
+                break;
+        }
+    }
+}
+
+void EvolvingSbmStream::applyChange(const PlantedChange& change) {
+    int numberCommunities = members.size();
+    auto checkCommunity = [&](int id) {
+        if (id < 0 || id >= numberCommunities || members[id].empty()) {
+            throw out_of_range("Planted change at " + to_string(change.at) + " refers to missing community " + to_string(id));
+        }
+    };
+
+    switch (change.type) {
+        case CommunityChange::Migrate: {
+            // A node alone in its community stays, so migrations never remove a community
+            int nonEmpty = count_if(members.begin(), members.end(), [](const vector<int>& nodes) { return !nodes.empty(); });
+            if (nonEmpty < 2) {
+                break;
+            }
+            uniform_int_distribution<int> pickNode(0, community.size() - 1);
+            uniform_int_distribution<int> pickCommunity(0, numberCommunities - 1);
+            for (int moved = 0; moved < change.count; ++moved) {
+                int nodeId = pickNode(gen);
+                if (members[community[nodeId]].size() == 1) {
+                    continue;
+                }
+                int target = pickCommunity(gen);
+                while (target == community[nodeId] || members[target].empty()) {
+                    target = pickCommunity(gen);
+                }
+                moveNode(nodeId, target);
+            }
+            break;
+        }
+        case CommunityChange::Merge: {
+            checkCommunity(change.community);
+            checkCommunity(change.target);
+            if (change.community == change.target) {
+                throw invalid_argument("Planted merge at " + to_string(change.at) + " merges a community into itself");
+            }
+            vector<int> absorbed = members[change.community];
+            for (int nodeId: absorbed) {
+                moveNode(nodeId, change.target);
+            }
+            break;
+        }
+        case CommunityChange::Split: {
+            checkCommunity(change.community);
+            vector<int> nodes = members[change.community];
+            shuffle(nodes.begin(), nodes.end(), gen);
+            members.emplace_back();
+            for (size_t i = 0; i < nodes.size() / 2; ++i) {
+                moveNode(nodes[i], numberCommunities);
+            }
+            break;
+        }
+        case CommunityChange::Drift: {
+            startIntra = currentIntraCommunityEdgeProbability();
+            startInter = currentInterCommunityEdgeProbability();
+            targetIntra = change.intraCommunityEdgeProbability;
+            targetInter = change.interCommunityEdgeProbability;
+            driftStart = numberAdditions();
+            driftDuration = change.duration;
+            break;
+        }
+    }
+    updatePairWeights();
+}
+
+void EvolvingSbmStream::updatePairWeights() {
+    intraPairWeights.resize(members.size());
+    intraPairs = 0;
+    for (size_t i = 0; i < members.size(); ++i) {
+        long long size = members[i].size();
+        intraPairs += size * (size - 1) / 2;
+        intraPairWeights[i] = intraPairs;
+    }
+}
+
+void EvolvingSbmStream::writeCheckpoint() {
+    checkpoints->write(position(), community);
+}
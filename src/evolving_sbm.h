@@ -0,0 +1,111 @@
+#ifndef EVOLVING_SBM_H
+#define EVOLVING_SBM_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <cstdint>
+#include <stdexcept>
+
+#include "dynamic_workload.h"
+
+using namespace std;
+
+
+enum class CommunityChange : uint8_t { Migrate = 0, Merge = 1, Split = 2, Drift = 3 };
+
+// Change to the planted partition or the edge probabilities, applied once `at` edges have been added
+struct PlantedChange {
+    CommunityChange type;
+    long long at = 0;
+    // Migrate: up to count random nodes each move to a random other community
+    int count = 0;
+    // Merge: community is absorbed into target. Split: half of community moves to a new one, which gets the next unused
+    // id. Communities start out as the planted block labels of the Sbm.
+    int community = -1;
+    int target = -1;
+    // Drift: probabilities move linearly to these values over duration additions
+    double intraCommunityEdgeProbability = 0.0;
+    double interCommunityEdgeProbability = 0.0;
+    long long duration = 0;
+};
+
+struct EvolutionConfig {
+    vector<PlantedChange> changes;
+    // Ground truth is written at the start, after every change and every checkpointInterval events
+    long long checkpointInterval = 0;
+    string checkpointPath;
+
+    bool isStatic() const { return changes.empty() && checkpointPath.empty(); }
+};
+
+struct PartitionCheckpointHeader {
+    char magic[4];      // "SBMP"
+    uint32_t version;
+    int32_t numberNodes;
+};
+
+// Ground truth partitions at event positions. Each record is the event position, the number of nodes whose
+// community changed since the previous record and {node, community} pairs for them, so the first record holds
+// every node and the rest only what moved.
+class PartitionCheckpointWriter {
+    public:
+        static const uint32_t binaryVersion = 1;
+
+        PartitionCheckpointWriter(const string& filepath, int numberNodes);
+        ~PartitionCheckpointWriter();
+
+        void write(long long position, const vector<int>& communities);
+
+    private:
+        ofstream file;
+        string filepath;
+        vector<int> previous;
+};
+
+// Full partitions of a checkpoint file as {event position, community per node}
+vector<pair<long long, vector<int>>> readPartitionCheckpoints(const string& filepath);
+
+// Sbm edge stream whose planted partition and probabilities evolve. Nodes migrate between communities,
+// communities merge and split, and p/q drift, on the schedule of the planted changes. Window, churn and node
+// turnover of the workload apply on top, so with a window old edges of a changed structure age out.
+class EvolvingSbmStream: public WorkloadEdgeStream {
+    public:
+        EvolvingSbmStream(Sbm& sbm, const WorkloadConfig& workload, const EvolutionConfig& evolution);
+        bool next(EdgeEvent& event) override;
+
+        // Community of every node (by id) at the current position
+        const vector<int>& currentPartition() const { return community; }
+        double currentIntraCommunityEdgeProbability() const;
+        double currentInterCommunityEdgeProbability() const;
+
+    protected:
+        pair<int, int> sampleEdge() override;
+
+    private:
+        EvolutionConfig evolution;
+        size_t nextChange;
+        mt19937_64 gen;
+        vector<int> community;
+        vector<vector<int>> members;
+        vector<size_t> memberPosition;
+        vector<double> intraPairWeights;    // prefix sums of pairs within each community
+        long long intraPairs;
+        long long totalPairs;
+        // Drift in progress, from the values at driftStart
+        double startIntra, startInter, targetIntra, targetInter;
+        long long driftStart, driftDuration;
+        unique_ptr<PartitionCheckpointWriter> checkpoints;
+        long long nextCheckpoint;
+
+        void moveNode(int nodeId, int target);
+        void validateChanges() const;
+        void applyChange(const PlantedChange& change);
+        void updatePairWeights();
+        void writeCheckpoint();
+        long long position() const { return numberAdditions() + numberRemovals(); }
+};
+
+#endif // EVOLVING_SBM_H
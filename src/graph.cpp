@@ -1,132 +1,340 @@
 #include "graph.h"
+#include "csr_graph.h"
 #include "utils/color_map.h"
 
 #include <graphviz/cgraph.h>
 #include <graphviz/gvc.h>
 #include <map>
-
-Node::Node(int id, int label): id(id), label(label), offset(-1), edgeList{}, messages{}, degree(0) {}
-
-Node::~Node() {
-    // Nothing to clean
+#include <stdexcept>
+#include <limits>
+#include <queue>
+#include <numeric>
+
+template <typename IdType, typename WeightType, typename LabelType>
+BasicNode<IdType, WeightType, LabelType>::BasicNode(IdType id, LabelType label, pmr::memory_resource* resource):
+    id(id), label(label), offset(-1), degree(0), edgeList(resource) {}
+
+template <typename IdType, typename WeightType, typename LabelType>
+BasicNode<IdType, WeightType, LabelType>::~BasicNode() {
+    releaseEdgeIndex();
 }
 
-void Node::addEdge(Node* destination, int edgeWeight) {
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicNode<IdType, WeightType, LabelType>::addEdge(BasicNode* destination, WeightType edgeWeight) {
     // Don't add edge entry if edge weight is 0
     if (edgeWeight == 0) {
         return;
     }
 
-    auto it = find_if(edgeList.begin(), edgeList.end(),
-                [&](const pair<Node*, int>& edge) {
-                    return edge.first->id == destination->id;
-                });
-    if (it != edgeList.end()) {
-        it->second += edgeWeight;
+    int slot = findEdge(destination->id);
+    if (slot != -1) {
+        edgeList[slot].second += edgeWeight;
     } else {
         edgeList.emplace_back(destination, edgeWeight);
+        if (edgeIndex) {
+            edgeIndex->emplace(destination->id, edgeList.size() - 1);
+        } else if (edgeList.size() > hubThreshold) {
+            buildEdgeIndex();
+        }
     }
     degree += edgeWeight;
 }
 
+// Returns slot of the edge in edgeList, or -1 if there is no edge to destinationId
+template <typename IdType, typename WeightType, typename LabelType>
+int BasicNode<IdType, WeightType, LabelType>::findEdge(IdType destinationId) const {
+    if (edgeIndex) {
+        auto it = edgeIndex->find(destinationId);
+        return (it == edgeIndex->end()) ? -1 : it->second;
+    }
+
+    for (size_t slot = 0; slot < edgeList.size(); ++slot) {
+        if (edgeList[slot].first->id == destinationId) {
+            return (int) slot;
+        }
+    }
+    return -1;
+}
+
+// Removes edge entry by swapping the last entry into its slot, returns removed weight
+template <typename IdType, typename WeightType, typename LabelType>
+WeightType BasicNode<IdType, WeightType, LabelType>::removeEdge(IdType destinationId) {
+    int slot = findEdge(destinationId);
+    if (slot == -1) {
+        return 0;
+    }
+
+    WeightType edgeWeight = edgeList[slot].second;
+    int lastSlot = edgeList.size() - 1;
+    if (slot != lastSlot) {
+        edgeList[slot] = edgeList[lastSlot];
+        if (edgeIndex) {
+            (*edgeIndex)[edgeList[slot].first->id] = slot;
+        }
+    }
+    edgeList.pop_back();
+    if (edgeIndex) {
+        edgeIndex->erase(destinationId);
+        // Demote below half the threshold, so a hub hovering around it doesn't rebuild its index on every change
+        if (edgeList.size() <= hubThreshold / 2) {
+            releaseEdgeIndex();
+        }
+    }
+    degree -= edgeWeight;
+
+    return edgeWeight;
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicNode<IdType, WeightType, LabelType>::buildEdgeIndex() {
+    if (!edgeIndex) {
+        pmr::polymorphic_allocator<pmr::unordered_map<IdType, int>> allocator(edgeList.get_allocator().resource());
+        edgeIndex = allocator.allocate(1);
+        allocator.construct(edgeIndex);
+    }
+    edgeIndex->clear();
+    edgeIndex->reserve(edgeList.size());
+    for (size_t slot = 0; slot < edgeList.size(); ++slot) {
+        edgeIndex->emplace(edgeList[slot].first->id, (int) slot);
+    }
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicNode<IdType, WeightType, LabelType>::releaseEdgeIndex() {
+    if (edgeIndex) {
+        pmr::polymorphic_allocator<pmr::unordered_map<IdType, int>> allocator(edgeList.get_allocator().resource());
+        edgeIndex->~unordered_map();
+        allocator.deallocate(edgeIndex, 1);
+        edgeIndex = nullptr;
+    }
+}
+
 // Constructor to initialize graph with a certain number of nodes
-Graph::Graph(int numberNodes) {
-    for (int i = 0; i < numberNodes; ++i) {
-        auto node = make_unique<Node>(i, i);
-        Node* nodePtr = node.get();
-        nodes.push_back(move(node));
+template <typename IdType, typename WeightType, typename LabelType>
+BasicGraph<IdType, WeightType, LabelType>::BasicGraph(size_t numberNodes) {
+    // Every node starts in its own community, labels past the range of LabelType would wrap onto earlier ones
+    if (numberNodes > static_cast<size_t>(numeric_limits<LabelType>::max())) {
+        throw invalid_argument("Graph: " + to_string(numberNodes) + " nodes don't fit one label each into the label type");
+    }
+    nodes.reserve(numberNodes);
+    for (size_t i = 0; i < numberNodes; ++i) {
+        appendNode(createNode(i, i));
         id_to_index_mapping.emplace(i, i);
+        indexLabel(nodes.back().get());
     }
 }
 
-Graph::~Graph() {
-    // Nothing to clean
+// Constructor to materialize a snapshot, for example one mapped from a binary graph file
+template <typename IdType, typename WeightType, typename LabelType>
+BasicGraph<IdType, WeightType, LabelType>::BasicGraph(const CsrGraph& snapshot) {
+    int numberNodes = snapshot.numberNodes();
+    nodes.reserve(numberNodes);
+    id_to_index_mapping.reserve(numberNodes);
+    for (int i = 0; i < numberNodes; ++i) {
+        IdType nodeId = static_cast<IdType>(snapshot.getId(i));
+        NodeType* node = appendNode(createNode(nodeId, static_cast<LabelType>(snapshot.getLabel(i))));
+        node->degree = snapshot.getDegree(i);
+        node->edgeList.reserve(snapshot.neighborEnd(i) - snapshot.neighborBegin(i));
+        id_to_index_mapping.emplace(nodeId, i);
+        indexLabel(node);
+        directedEdgeWeight += node->degree;
+    }
+
+    forEachNodeRange([&](size_t index) { return snapshot.neighborEnd(index) - snapshot.neighborBegin(index); },
+        [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                NodeType* node = nodes[i].get();
+                for (int position = snapshot.neighborBegin(i); position < snapshot.neighborEnd(i); ++position) {
+                    node->edgeList.emplace_back(nodes[snapshot.getNeighbor(position)].get(), snapshot.getWeight(position));
+                }
+            }
+        });
+    buildHubIndices();
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+BasicGraph<IdType, WeightType, LabelType>::~BasicGraph() {
+    // Everything a node owns is allocated from memoryPool, so skip the per node destructors and let the pool
+    // free its chunks in bulk
+    for (auto& node: nodes) {
+        node.release();
+    }
 }
 
 // Move constructor
-Graph::Graph(Graph&& other) noexcept
-    : nodes(move(other.nodes)),
-        id_to_index_mapping(move(other.id_to_index_mapping)) {}
+template <typename IdType, typename WeightType, typename LabelType>
+BasicGraph<IdType, WeightType, LabelType>::BasicGraph(BasicGraph&& other) noexcept
+    : memoryPool(move(other.memoryPool)),
+        directedEdgeWeight(other.directedEdgeWeight),
+        communityMembers(move(other.communityMembers)),
+        nodes(move(other.nodes)),
+        id_to_index_mapping(move(other.id_to_index_mapping)) {
+    other.directedEdgeWeight = 0;
+}
 
 // Move assignment operator
-Graph& Graph::operator=(Graph&& other) noexcept {
+template <typename IdType, typename WeightType, typename LabelType>
+BasicGraph<IdType, WeightType, LabelType>& BasicGraph<IdType, WeightType, LabelType>::operator=(BasicGraph&& other) noexcept {
     if (this != &other) {
+        // Nodes must go before the pool they were allocated from
         nodes = move(other.nodes);
+        memoryPool = move(other.memoryPool);
         id_to_index_mapping = move(other.id_to_index_mapping);
+        communityMembers = move(other.communityMembers);
+        directedEdgeWeight = other.directedEdgeWeight;
+        other.directedEdgeWeight = 0;
     }
     return *this;
 }
 
-// Copy Constructor
-Graph::Graph(const Graph& other) {
-    // Deep copy each node
-    for (const auto& node : other.nodes) {
-        auto newNode = make_unique<Node>(node->id, node->label);
-        newNode->offset = node->offset;
-        newNode->messages = node->messages;
-        nodes.push_back(move(newNode));
+template <typename IdType, typename WeightType, typename LabelType>
+pmr::memory_resource* BasicGraph<IdType, WeightType, LabelType>::getMemoryResource() {
+    // Moved-from graphs lose their pool, create a fresh one on demand
+    if (!memoryPool) {
+        memoryPool = make_unique<pmr::unsynchronized_pool_resource>();
     }
+    return memoryPool.get();
+}
 
-    id_to_index_mapping = other.id_to_index_mapping;
+template <typename IdType, typename WeightType, typename LabelType>
+typename BasicGraph<IdType, WeightType, LabelType>::NodePtr BasicGraph<IdType, WeightType, LabelType>::createNode(IdType nodeId, LabelType nodeLabel) {
+    pmr::memory_resource* resource = getMemoryResource();
+    void* memory = resource->allocate(sizeof(NodeType), alignof(NodeType));
+    return NodePtr(new (memory) NodeType(nodeId, nodeLabel, resource), NodeDeleter<NodeType>{resource});
+}
 
-    // Map old nodes to new nodes for correct edge assignment
-    for (const auto& node: other.nodes) {
-        for (const auto& edge: node->edgeList) {
-            int srcId = node->id;
-            int destId = edge.first->id;
-            int edgeWeight = edge.second;
-            Node* newSrcNode = getNode(srcId);
-            Node* newDestNode = getNode(destId);
-            if (newSrcNode && newDestNode) {
-                newSrcNode->edgeList.emplace_back(newDestNode, edgeWeight);
-            }
-        }
-    }
+// Copy Constructor
+template <typename IdType, typename WeightType, typename LabelType>
+BasicGraph<IdType, WeightType, LabelType>::BasicGraph(const BasicGraph& other) {
+    copyNodes(other);
 }
 
 // Copy Assignment Operator
-Graph& Graph::operator=(const Graph& other) {
+template <typename IdType, typename WeightType, typename LabelType>
+BasicGraph<IdType, WeightType, LabelType>& BasicGraph<IdType, WeightType, LabelType>::operator=(const BasicGraph& other) {
     if (this != &other) {
-        // Clear existing nodes and mapping
+        // Drop the old nodes together with their pool instead of destroying them one by one
+        for (auto& node: nodes) {
+            node.release();
+        }
         nodes.clear();
+        memoryPool.reset();
         id_to_index_mapping.clear();
+        communityMembers.clear();
 
-        // Deep copy each node
-        for (const auto& node : other.nodes) {
-            auto newNode = make_unique<Node>(node->id, node->label);
-            newNode->offset = node->offset;
-            newNode->messages = node->messages;
-            nodes.push_back(move(newNode));
-        }
+        copyNodes(other);
+    }
+    return *this;
+}
 
-        id_to_index_mapping = other.id_to_index_mapping;
+// Deep copy. Everything that allocates from the pool (nodes, edge list capacity, hub indices) happens on
+// this thread; edge entries are then rebased onto the copies by dense index on worker threads, while the id mapping
+// and community index are copied alongside.
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::copyNodes(const BasicGraph& other) {
+    nodes.reserve(other.nodes.size());
+    for (const auto& node: other.nodes) {
+        NodeType* newNode = appendNode(createNode(node->id, node->label));
+        newNode->offset = node->offset;
+        newNode->degree = node->degree;
+        newNode->edgeList.reserve(node->edgeList.size());
+    }
+    directedEdgeWeight = other.directedEdgeWeight;
 
-        // Map old nodes to new nodes for correct edge assignment
-        for (const auto& node: other.nodes) {
-            for (const auto& edge: node->edgeList) {
-                int srcId = node->id;
-                int destId = edge.first->id;
-                int edgeWeight = edge.second;
-                Node* newSrcNode = getNode(srcId);
-                Node* newDestNode = getNode(destId);
-                if (newSrcNode && newDestNode) {
-                    newSrcNode->edgeList.emplace_back(newDestNode, edgeWeight);
-                }
+    auto copyIndices = [&]() {
+        id_to_index_mapping = other.id_to_index_mapping;
+        communityMembers.reserve(other.communityMembers.size());
+        for (const auto& [nodeLabel, members]: other.communityMembers) {
+            vector<NodeType*>& newMembers = communityMembers[nodeLabel];
+            newMembers.reserve(members.size());
+            for (const NodeType* member: members) {
+                NodeType* newMember = nodes[member->denseIndex].get();
+                newMember->communityPosition = member->communityPosition;
+                newMembers.push_back(newMember);
             }
         }
+    };
+    auto copyEdges = [&](size_t first, size_t last) {
+        for (size_t index = first; index < last; ++index) {
+            NodeType* newNode = nodes[index].get();
+            for (const auto& edge: other.nodes[index]->edgeList) {
+                newNode->edgeList.emplace_back(nodes[edge.first->denseIndex].get(), edge.second);
+            }
+        }
+    };
+
+    forEachNodeRange([&](size_t index) { return other.nodes[index]->edgeList.size(); }, copyEdges, copyIndices);
+    buildHubIndices();
+}
+
+// Runs body over consecutive ranges of dense indices holding roughly equal numbers of edge entries, one range per
+// hardware thread, and side on one more thread meanwhile. Small graphs are not worth the threads and run both here.
+// body and side must not allocate from memoryPool.
+template <typename IdType, typename WeightType, typename LabelType>
+template <typename EntriesOf, typename Body, typename Side>
+void BasicGraph<IdType, WeightType, LabelType>::forEachNodeRange(EntriesOf entriesOf, Body body, Side side) {
+    size_t totalEntries = 0;
+    for (size_t index = 0; index < nodes.size(); ++index) {
+        totalEntries += entriesOf(index);
+    }
+
+    size_t threadCount = max(1u, thread::hardware_concurrency());
+    if (totalEntries < parallelEntries || threadCount == 1) {
+        body(0, nodes.size());
+        side();
+        return;
+    }
+
+    vector<thread> workers;
+    workers.emplace_back(side);
+    size_t entriesPerThread = (totalEntries + threadCount - 1) / threadCount;
+    size_t first = 0;
+    size_t entries = 0;
+    for (size_t index = 0; index < nodes.size(); ++index) {
+        entries += entriesOf(index);
+        if (entries >= entriesPerThread || index + 1 == nodes.size()) {
+            workers.emplace_back(body, first, index + 1);
+            first = index + 1;
+            entries = 0;
+        }
+    }
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+template <typename EntriesOf, typename Body>
+void BasicGraph<IdType, WeightType, LabelType>::forEachNodeRange(EntriesOf entriesOf, Body body) {
+    forEachNodeRange(entriesOf, body, []() {});
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+typename BasicGraph<IdType, WeightType, LabelType>::NodeType* BasicGraph<IdType, WeightType, LabelType>::appendNode(NodePtr node) {
+    node->denseIndex = nodes.size();
+    nodes.push_back(move(node));
+    return nodes.back().get();
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::buildHubIndices() {
+    for (const auto& node: nodes) {
+        if (node->edgeList.size() > NodeType::hubThreshold) {
+            node->buildEdgeIndex();
+        }
     }
-    return *this;
 }
 
-void Graph::draw(const string &filepath) {
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::draw(const string &filepath) {
     // Create a new graph
     Agraph_t *g = agopen(const_cast<char*>("g"), Agundirected, NULL);
 
     // Create a map to store subgraphs for each label
-    map<int, Agraph_t*> subgraph_map;
+    map<LabelType, Agraph_t*> subgraph_map;
 
     // Create a map to store the Agnode_t* for each node id
-    map<int, Agnode_t*> agnode_map;
+    map<IdType, Agnode_t*> agnode_map;
 
     // Create subgraphs for each label
     for (const auto& node: nodes) {
@@ -156,12 +364,12 @@ void Graph::draw(const string &filepath) {
     for (const auto& node: nodes) {
         Agnode_t *agnode_src = agnode_map[node->id];
         for (const auto& edge: node->edgeList) {
-            int dest = edge.first->id;
+            IdType dest = edge.first->id;
             // int weight = get<2>(edge);
             Agnode_t *agnode_dest = agnode_map[dest];
             Agedge_t *ag_edge = agedge(g, agnode_src, agnode_dest, NULL, 1);
 
-            string edge_color = getEdgeColor(node->label, nodes[dest]->label);
+            string edge_color = getEdgeColor(node->label, edge.first->label);
 
             // Set edge color
             agsafeset(ag_edge, const_cast<char*>("color"), const_cast<char*>(edge_color.c_str()), const_cast<char*>(""));
@@ -185,7 +393,8 @@ void Graph::draw(const string &filepath) {
     gvFreeContext(gvc);
 }
 
-string Graph::getEdgeColor(int srcLabel, int destLabel) {
+template <typename IdType, typename WeightType, typename LabelType>
+string BasicGraph<IdType, WeightType, LabelType>::getEdgeColor(LabelType srcLabel, LabelType destLabel) {
     if (srcLabel == destLabel) {
         return "#00FF00"; // Green color in hex
     } else {
@@ -193,7 +402,8 @@ string Graph::getEdgeColor(int srcLabel, int destLabel) {
     }
 }
 
-string Graph::getNodeColor(int nodeLabel) {
+template <typename IdType, typename WeightType, typename LabelType>
+string BasicGraph<IdType, WeightType, LabelType>::getNodeColor(LabelType nodeLabel) {
     if (colorMap.find(nodeLabel) != colorMap.end()) {
         return colorMap[nodeLabel];
     } else {
@@ -203,17 +413,13 @@ string Graph::getNodeColor(int nodeLabel) {
 }
 
 // Total edges includes weight as well
-int Graph::getTotalEdges() const {
-    int edgeCount = 0;
-    for (const auto& node: nodes) {
-        for (const auto& edge: node->edgeList) {
-            edgeCount += edge.second;
-        }
-    }
-    return edgeCount / 2;
+template <typename IdType, typename WeightType, typename LabelType>
+WeightSum<WeightType> BasicGraph<IdType, WeightType, LabelType>::getTotalEdges() const {
+    return directedEdgeWeight / 2;
 }
 
-const Node* Graph::getNode(int nodeId) const {
+template <typename IdType, typename WeightType, typename LabelType>
+const typename BasicGraph<IdType, WeightType, LabelType>::NodeType* BasicGraph<IdType, WeightType, LabelType>::getNode(IdType nodeId) const {
     auto it = id_to_index_mapping.find(nodeId);
     if (it == id_to_index_mapping.end()) {
         throw out_of_range("Node with id " + to_string(nodeId) + " not found in id to index mapping.");
@@ -221,7 +427,8 @@ const Node* Graph::getNode(int nodeId) const {
     return nodes[it->second].get();
 }
 
-Node* Graph::getNode(int nodeId) {
+template <typename IdType, typename WeightType, typename LabelType>
+typename BasicGraph<IdType, WeightType, LabelType>::NodeType* BasicGraph<IdType, WeightType, LabelType>::getNode(IdType nodeId) {
     auto it = id_to_index_mapping.find(nodeId);
     if (it == id_to_index_mapping.end()) {
         throw out_of_range("Node with id " + to_string(nodeId) + " not found in id to index mapping.");
@@ -229,43 +436,153 @@ Node* Graph::getNode(int nodeId) {
     return nodes[it->second].get();
 }
 
-void Graph::addUndirectedEdge(Node* srcNode, Node* destNode, int edgeWeight) {
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::addEdge(NodeType* srcNode, NodeType* destNode, WeightType edgeWeight) {
     srcNode->addEdge(destNode, edgeWeight);
-    destNode->addEdge(srcNode, edgeWeight); // Since the graph is undirected
+    directedEdgeWeight += edgeWeight;
 }
 
-void Graph::addUndirectedEdge(int srcNodeId, int destNodeId, int edgeWeight) {
-    Node* srcNode = getNode(srcNodeId);
-    Node* destNode = getNode(destNodeId);
-    addUndirectedEdge(srcNode, destNode);
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::addUndirectedEdge(NodeType* srcNode, NodeType* destNode, WeightType edgeWeight) {
+    addEdge(srcNode, destNode, edgeWeight);
+    addEdge(destNode, srcNode, edgeWeight); // Since the graph is undirected
 }
 
-int Graph::getEdgeWeight(int srcNodeId, int destNodeId) {
-    Node* src = getNode(srcNodeId);
-    auto it = find_if(src->edgeList.begin(), src->edgeList.end(),
-                [&](const pair<Node*, int>& edge) {
-                    return edge.first->id == destNodeId;
-                });
-    if (it == src->edgeList.end()) {
-        return 0;
-    }
-    return it->second;
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::addUndirectedEdge(IdType srcNodeId, IdType destNodeId, WeightType edgeWeight) {
+    NodeType* srcNode = getNode(srcNodeId);
+    NodeType* destNode = getNode(destNodeId);
+    addUndirectedEdge(srcNode, destNode, edgeWeight);
 }
 
-void Graph::removeEdge(int srcNodeId, int destNodeId) {
-    Node* src = getNode(srcNodeId);
-    auto it = find_if(src->edgeList.begin(), src->edgeList.end(),
-                [&](const pair<Node*, int>& edge) {
-                    return edge.first->id == destNodeId;
-                });
+// Adds undirected edges in one pass: entries are sorted by source, duplicates are coalesced into their weight and
+// each edge list grows once. Weights default to 1. With parallel set, nodes without prior edges are filled by
+// worker threads over disjoint source ranges.
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::addEdgesBulk(const vector<pair<IdType, IdType>>& edges, const vector<WeightType>& edgeWeights, bool parallel) {
+    if (!edgeWeights.empty() && edgeWeights.size() != edges.size()) {
+        throw invalid_argument("addEdgesBulk: Expected one weight per edge.");
+    }
 
-    if (it != src->edgeList.end()) {
-        src->degree -= it->second;
-        src->edgeList.erase(it);
+    struct DirectedEntry {
+        size_t src;
+        size_t dest;
+        WeightType weight;
+    };
+
+    // Expand undirected edges into directed entries over dense indices
+    vector<DirectedEntry> entries;
+    entries.reserve(2 * edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        WeightType edgeWeight = edgeWeights.empty() ? 1 : edgeWeights[i];
+        if (edgeWeight == 0) {
+            continue;
+        }
+        size_t srcIndex = id_to_index_mapping.at(edges[i].first);
+        size_t destIndex = id_to_index_mapping.at(edges[i].second);
+        if (srcIndex == destIndex) {
+            // Self loop counts both directions on a single entry, same as addUndirectedEdge
+            entries.push_back({srcIndex, destIndex, static_cast<WeightType>(2 * edgeWeight)});
+        } else {
+            entries.push_back({srcIndex, destIndex, edgeWeight});
+            entries.push_back({destIndex, srcIndex, edgeWeight});
+        }
     }
+
+    sort(entries.begin(), entries.end(), [](const DirectedEntry& left, const DirectedEntry& right) {
+        return left.src < right.src || (left.src == right.src && left.dest < right.dest);
+    });
+
+    // Coalesce duplicates into weights
+    size_t entryCount = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        directedEdgeWeight += entries[i].weight;
+        if (entryCount > 0 && entries[entryCount - 1].src == entries[i].src && entries[entryCount - 1].dest == entries[i].dest) {
+            entries[entryCount - 1].weight += entries[i].weight;
+        } else {
+            entries[entryCount++] = entries[i];
+        }
+    }
+    entries.resize(entryCount);
+
+    // Source runs, reserving capacity once per node. Nodes that already have edges need duplicate checks and are merged
+    // through addEdge, new nodes can be appended directly.
+    vector<pair<size_t, size_t>> appendRuns;
+    vector<pair<size_t, size_t>> mergeRuns;
+    for (size_t begin = 0; begin < entries.size();) {
+        size_t end = begin;
+        while (end < entries.size() && entries[end].src == entries[begin].src) {
+            end++;
+        }
+        NodeType* node = nodes[entries[begin].src].get();
+        node->edgeList.reserve(node->edgeList.size() + (end - begin));
+        if (node->edgeList.empty()) {
+            appendRuns.emplace_back(begin, end);
+        } else {
+            mergeRuns.emplace_back(begin, end);
+        }
+        begin = end;
+    }
+
+    // Capacity is reserved, so appends don't allocate from the (unsynchronized) memory pool
+    auto appendRange = [&](size_t firstRun, size_t lastRun) {
+        for (size_t run = firstRun; run < lastRun; ++run) {
+            NodeType* node = nodes[entries[appendRuns[run].first].src].get();
+            for (size_t i = appendRuns[run].first; i < appendRuns[run].second; ++i) {
+                node->edgeList.emplace_back(nodes[entries[i].dest].get(), entries[i].weight);
+                node->degree += entries[i].weight;
+            }
+        }
+    };
+
+    size_t threadCount = parallel ? max(1u, thread::hardware_concurrency()) : 1;
+    threadCount = min(threadCount, max<size_t>(1, appendRuns.size()));
+    if (threadCount == 1) {
+        appendRange(0, appendRuns.size());
+    } else {
+        vector<thread> workers;
+        size_t runsPerThread = (appendRuns.size() + threadCount - 1) / threadCount;
+        for (size_t first = 0; first < appendRuns.size(); first += runsPerThread) {
+            workers.emplace_back(appendRange, first, min(first + runsPerThread, appendRuns.size()));
+        }
+        for (auto& worker: workers) {
+            worker.join();
+        }
+    }
+
+    // Index allocation goes through the memory pool, so it stays on this thread
+    for (const auto& run: appendRuns) {
+        NodeType* node = nodes[entries[run.first].src].get();
+        if (node->edgeList.size() > NodeType::hubThreshold) {
+            node->buildEdgeIndex();
+        }
+    }
+
+    for (const auto& run: mergeRuns) {
+        NodeType* node = nodes[entries[run.first].src].get();
+        for (size_t i = run.first; i < run.second; ++i) {
+            node->addEdge(nodes[entries[i].dest].get(), entries[i].weight);
+        }
+    }
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+WeightType BasicGraph<IdType, WeightType, LabelType>::getEdgeWeight(IdType srcNodeId, IdType destNodeId) {
+    NodeType* src = getNode(srcNodeId);
+    int slot = src->findEdge(destNodeId);
+    if (slot == -1) {
+        return 0;
+    }
+    return src->edgeList[slot].second;
 }
 
-void Graph::removeUndirectedEdge(int srcNodeId, int destNodeId) {
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::removeEdge(IdType srcNodeId, IdType destNodeId) {
+    directedEdgeWeight -= getNode(srcNodeId)->removeEdge(destNodeId);
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::removeUndirectedEdge(IdType srcNodeId, IdType destNodeId) {
     removeEdge(srcNodeId, destNodeId);
     // Since the graph is undirected
     if (srcNodeId != destNodeId) {
@@ -273,47 +590,252 @@ void Graph::removeUndirectedEdge(int srcNodeId, int destNodeId) {
     }
 }
 
-void Graph::addNode(int nodeId, int nodeLabel) {
-    // Create node and push it to the node queue
-    auto node = make_unique<Node>(nodeId, nodeLabel);
-    Node* nodePtr = node.get();
-    nodes.push_back(move(node));
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::addNode(IdType nodeId, LabelType nodeLabel) {
+    // Create node and push it to the end of the node list
+    size_t nodeIndex = nodes.size();
+    NodeType* node = appendNode(createNode(nodeId, nodeLabel));
 
     // Update mappings
-    int nodeIndex = id_to_index_mapping.size();
     id_to_index_mapping.emplace(nodeId, nodeIndex);
+    indexLabel(node);
 }
 
-void Graph::removeNode(int nodeId) {
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::removeNode(IdType nodeId) {
     try {
-        int nodeIndex = id_to_index_mapping.at(nodeId);
+        size_t nodeIndex = id_to_index_mapping.at(nodeId);
+
+        NodeType* node = nodes[nodeIndex].get();
+        // First, so a stale label throws before any edge is removed
+        unindexLabel(node);
 
-        Node* node = nodes[nodeIndex].get();
         // Remove edge entry from all neighbors
         for (const auto& edge: node->edgeList) {
-            Node* targetNode = edge.first;
+            NodeType* targetNode = edge.first;
             if (targetNode->id != nodeId) {
                 removeEdge(targetNode->id, nodeId);
             }
         }
 
-        // Remove node from list
-        nodes.erase(nodes.begin() + nodeIndex);
+        directedEdgeWeight -= node->degree;
+
+        // Swap with the last node and pop, so remaining nodes keep their index except the moved one
+        size_t lastIndex = nodes.size() - 1;
+        if (nodeIndex != lastIndex) {
+            swap(nodes[nodeIndex], nodes[lastIndex]);
+            nodes[nodeIndex]->denseIndex = nodeIndex;
+            id_to_index_mapping[nodes[nodeIndex]->id] = nodeIndex;
+        }
+        nodes.pop_back();
 
         // Update mappings
         id_to_index_mapping.erase(nodeId);
-        for (int i = nodeIndex; i < nodes.size(); ++i) {
-            id_to_index_mapping[nodes[i]->id] = i;
-        }
     } catch (const out_of_range& e) {
         cerr << "Node with id " << nodeId << " not found in id to index mapping." << endl;
+    } catch (const logic_error& e) {
+        throw;
     } catch (const exception& e) {
         throw runtime_error("An error occurred while removing the node: " + string(e.what()));
     }
 }
 
-unordered_map<int, int> Graph::getLabels() const {
-    unordered_map<int, int> predicted_labels{};
+// Permutes dense node storage for locality. Nodes are reallocated in the new order from a fresh pool and edge lists
+// are sorted by neighbor index, ids stay the same so id_to_index_mapping keeps resolving external ids.
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::reorderNodes(NodeOrder order) {
+    if (order == NodeOrder::None || nodes.size() < 2) {
+        return;
+    }
+
+    vector<size_t> permutation = getNodeOrder(order); // new index -> old index
+    vector<size_t> newIndices(nodes.size());
+    for (size_t newIndex = 0; newIndex < permutation.size(); ++newIndex) {
+        newIndices[permutation[newIndex]] = newIndex;
+    }
+
+    BasicGraph reordered(0);
+    reordered.nodes.reserve(nodes.size());
+    reordered.id_to_index_mapping.reserve(nodes.size());
+    for (size_t oldIndex: permutation) {
+        const NodeType* node = nodes[oldIndex].get();
+        reordered.id_to_index_mapping.emplace(node->id, reordered.nodes.size());
+        NodeType* newNode = reordered.appendNode(reordered.createNode(node->id, node->label));
+        newNode->offset = node->offset;
+    }
+
+    vector<pair<size_t, WeightType>> sortedEdges;
+    for (size_t newIndex = 0; newIndex < permutation.size(); ++newIndex) {
+        const NodeType* node = nodes[permutation[newIndex]].get();
+        sortedEdges.clear();
+        for (const auto& edge: node->edgeList) {
+            sortedEdges.emplace_back(newIndices[edge.first->denseIndex], edge.second);
+        }
+        sort(sortedEdges.begin(), sortedEdges.end());
+
+        NodeType* newNode = reordered.nodes[newIndex].get();
+        newNode->edgeList.reserve(sortedEdges.size());
+        for (const auto& [destIndex, edgeWeight]: sortedEdges) {
+            newNode->edgeList.emplace_back(reordered.nodes[destIndex].get(), edgeWeight);
+        }
+        newNode->degree = node->degree;
+        if (newNode->edgeList.size() > NodeType::hubThreshold) {
+            newNode->buildEdgeIndex();
+        }
+    }
+    reordered.directedEdgeWeight = directedEdgeWeight;
+    reordered.rebuildCommunityIndex();
+
+    *this = move(reordered);
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+vector<size_t> BasicGraph<IdType, WeightType, LabelType>::getNodeOrder(NodeOrder order) const {
+    vector<size_t> permutation(nodes.size());
+    iota(permutation.begin(), permutation.end(), 0);
+
+    switch (order) {
+        case NodeOrder::Degree:
+            stable_sort(permutation.begin(), permutation.end(), [&](size_t left, size_t right) {
+                return nodes[left]->degree > nodes[right]->degree;
+            });
+            break;
+        case NodeOrder::ReverseCuthillMcKee:
+            permutation = getReverseCuthillMcKeeOrder();
+            break;
+        case NodeOrder::Community:
+            stable_sort(permutation.begin(), permutation.end(), [&](size_t left, size_t right) {
+                return nodes[left]->label < nodes[right]->label;
+            });
+            break;
+        case NodeOrder::None:
+            break;
+    }
+
+    return permutation;
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+vector<size_t> BasicGraph<IdType, WeightType, LabelType>::getReverseCuthillMcKeeOrder() const {
+    vector<size_t> permutation;
+    permutation.reserve(nodes.size());
+    vector<bool> visited(nodes.size(), false);
+
+    auto byNeighborCount = [&](size_t left, size_t right) {
+        return nodes[left]->edgeList.size() < nodes[right]->edgeList.size();
+    };
+
+    // Start each component from its lowest degree node
+    vector<size_t> startCandidates(nodes.size());
+    iota(startCandidates.begin(), startCandidates.end(), 0);
+    stable_sort(startCandidates.begin(), startCandidates.end(), byNeighborCount);
+
+    vector<size_t> neighbors;
+    for (size_t start: startCandidates) {
+        if (visited[start]) {
+            continue;
+        }
+
+        queue<size_t> bfsQueue;
+        bfsQueue.push(start);
+        visited[start] = true;
+        while (!bfsQueue.empty()) {
+            size_t current = bfsQueue.front();
+            bfsQueue.pop();
+            permutation.push_back(current);
+
+            // Enqueue unvisited neighbors by increasing degree
+            neighbors.clear();
+            for (const auto& edge: nodes[current]->edgeList) {
+                size_t neighbor = edge.first->denseIndex;
+                if (!visited[neighbor]) {
+                    visited[neighbor] = true;
+                    neighbors.push_back(neighbor);
+                }
+            }
+            stable_sort(neighbors.begin(), neighbors.end(), byNeighborCount);
+            for (size_t neighbor: neighbors) {
+                bfsQueue.push(neighbor);
+            }
+        }
+    }
+
+    reverse(permutation.begin(), permutation.end());
+    return permutation;
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::indexLabel(NodeType* node) {
+    vector<NodeType*>& members = communityMembers[node->label];
+    node->communityPosition = members.size();
+    members.push_back(node);
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::unindexLabel(NodeType* node) {
+    auto it = communityMembers.find(node->label);
+    // Fails when the label was written directly instead of through setLabel
+    if (it == communityMembers.end()) {
+        throw logic_error("Label of node " + to_string(node->id) + " was changed without setLabel");
+    }
+    vector<NodeType*>& members = it->second;
+    if (node->communityPosition >= members.size() || members[node->communityPosition] != node) {
+        throw logic_error("Label of node " + to_string(node->id) + " was changed without setLabel");
+    }
+    NodeType* lastMember = members.back();
+    members[node->communityPosition] = lastMember;
+    lastMember->communityPosition = node->communityPosition;
+    members.pop_back();
+    if (members.empty()) {
+        communityMembers.erase(it);
+    }
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::rebuildCommunityIndex() {
+    communityMembers.clear();
+    for (const auto& node: nodes) {
+        indexLabel(node.get());
+    }
+}
+
+// Moves a node to another community in O(1)
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::setLabel(NodeType* node, LabelType nodeLabel) {
+    if (node->label == nodeLabel) {
+        return;
+    }
+    unindexLabel(node);
+    node->label = nodeLabel;
+    indexLabel(node);
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+void BasicGraph<IdType, WeightType, LabelType>::setLabel(IdType nodeId, LabelType nodeLabel) {
+    setLabel(getNode(nodeId), nodeLabel);
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+const unordered_map<LabelType, vector<typename BasicGraph<IdType, WeightType, LabelType>::NodeType*>>& BasicGraph<IdType, WeightType, LabelType>::getCommunityMembers() const {
+    return communityMembers;
+}
+
+// Members of a community, empty if no node carries the label
+template <typename IdType, typename WeightType, typename LabelType>
+const vector<typename BasicGraph<IdType, WeightType, LabelType>::NodeType*>& BasicGraph<IdType, WeightType, LabelType>::getCommunity(LabelType nodeLabel) const {
+    static const vector<NodeType*> noMembers;
+    auto it = communityMembers.find(nodeLabel);
+    return (it == communityMembers.end()) ? noMembers : it->second;
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+size_t BasicGraph<IdType, WeightType, LabelType>::numberCommunities() const {
+    return communityMembers.size();
+}
+
+template <typename IdType, typename WeightType, typename LabelType>
+unordered_map<IdType, LabelType> BasicGraph<IdType, WeightType, LabelType>::getLabels() const {
+    unordered_map<IdType, LabelType> predicted_labels{};
     for (const auto& node: nodes) {
         predicted_labels.emplace(node->id, node->label);
     }
@@ -321,10 +843,34 @@ unordered_map<int, int> Graph::getLabels() const {
     return predicted_labels;
 }
 
-unordered_map<int, set<int>> Graph::getCommunities() const {
-    unordered_map<int, set<int>> community_clusters{};
-    for (const auto& node: nodes) {
-        community_clusters[node->label].insert(node->id);
+template <typename IdType, typename WeightType, typename LabelType>
+unordered_map<LabelType, set<IdType>> BasicGraph<IdType, WeightType, LabelType>::getCommunities() const {
+    unordered_map<LabelType, set<IdType>> community_clusters{};
+    community_clusters.reserve(communityMembers.size());
+    for (const auto& [nodeLabel, members]: communityMembers) {
+        set<IdType>& cluster = community_clusters[nodeLabel];
+        for (const NodeType* node: members) {
+            cluster.insert(node->id);
+        }
     }
     return community_clusters;
 }
+
+// Explicit instantiations, see BasicGraph
+#define INSTANTIATE_GRAPH(IdType, WeightType, LabelType) \
+    template class BasicNode<IdType, WeightType, LabelType>; \
+    template class BasicGraph<IdType, WeightType, LabelType>;
+
+#define INSTANTIATE_GRAPH_LABELS(IdType, WeightType) \
+    INSTANTIATE_GRAPH(IdType, WeightType, uint8_t) \
+    INSTANTIATE_GRAPH(IdType, WeightType, uint16_t) \
+    INSTANTIATE_GRAPH(IdType, WeightType, uint32_t)
+
+#define INSTANTIATE_GRAPH_WEIGHTS(IdType) \
+    INSTANTIATE_GRAPH_LABELS(IdType, uint8_t) \
+    INSTANTIATE_GRAPH_LABELS(IdType, uint32_t) \
+    INSTANTIATE_GRAPH_LABELS(IdType, float)
+
+INSTANTIATE_GRAPH(int, int, int)
+INSTANTIATE_GRAPH_WEIGHTS(uint32_t)
+INSTANTIATE_GRAPH_WEIGHTS(uint64_t)
@@ -8,59 +8,176 @@
 #include <unordered_map>
 #include <set>
 #include <memory>
+#include <memory_resource>
 #include <utility>
+#include <thread>
+#include <type_traits>
+#include <cstdint>
 
 using namespace std;
 
 
-class Node {
+// Accumulator for sums of edge weights (degrees, total edge weight), wide enough not to overflow the weight type
+template <typename WeightType>
+using WeightSum = conditional_t<is_floating_point_v<WeightType>, double, long long>;
+
+template <typename IdType, typename WeightType, typename LabelType>
+class BasicGraph;
+
+// Graph node over id, edge weight and label types. Node is the int instantiation used throughout the algorithms.
+template <typename IdType = int, typename WeightType = int, typename LabelType = int>
+class BasicNode {
     public:
-        int id;
-        int label;
+        IdType id;
+        // Read freely, but write through Graph::setLabel so the community index stays in sync
+        LabelType label;
         int offset;
-        int degree;
+        WeightSum<WeightType> degree;
         // TODO: need to store only address, all edge info will be stored in a very long list
-        vector<pair<Node*, int>> edgeList; // {dest_address, weight}
-        unordered_map<int, vector<double>> messages;
+        pmr::vector<pair<BasicNode*, WeightType>> edgeList; // {dest_address, weight}
+
+        BasicNode(IdType id, LabelType label = static_cast<LabelType>(-1), pmr::memory_resource* resource = pmr::get_default_resource());
+        ~BasicNode();
+        BasicNode(const BasicNode&) = delete;
+        BasicNode& operator=(const BasicNode&) = delete;
+        void addEdge(BasicNode* destination, WeightType edgeWeight = 1);
+        int findEdge(IdType destinationId) const;
+        WeightType removeEdge(IdType destinationId);
+        bool isHub() const { return edgeIndex != nullptr; }
+        // Position of this node in Graph::nodes, changes when nodes are removed or reordered
+        size_t getDenseIndex() const { return denseIndex; }
+
+        // Nodes with more than threshold neighbors are promoted to hubs with a hashed neighbor index, and demoted
+        // again once they fall to half of it. Applies to nodes of this instantiation as their edge lists change.
+        static void setHubThreshold(size_t threshold) { hubThreshold = threshold; }
+        static size_t getHubThreshold() { return hubThreshold; }
+
+    private:
+        friend class BasicGraph<IdType, WeightType, LabelType>;
 
-        Node(int id, int label = -1);
-        ~Node();
-        void addEdge(Node* destination, int edgeWeight = 1);
+        static inline size_t hubThreshold = 32;
+        // Neighbor id to edgeList slot, allocated from the graph pool on promotion so low degree nodes only carry a
+        // null pointer next to their edge list
+        pmr::unordered_map<IdType, int>* edgeIndex = nullptr;
+        // Slot of this node in its community member list
+        size_t communityPosition = 0;
+        // Position of this node in Graph::nodes
+        size_t denseIndex = 0;
+
+        void buildEdgeIndex();
+        void releaseEdgeIndex();
+};
+
+// Node layout used by Graph::reorderNodes
+enum class NodeOrder {
+    None,
+    Degree,                 // Highest degree first
+    ReverseCuthillMcKee,    // Bandwidth reducing BFS order
+    Community               // Grouped by current label
 };
 
-class Graph {
+// Returns a node to the memory pool of the graph that allocated it
+template <typename NodeType>
+struct NodeDeleter {
+    pmr::memory_resource* resource;
+
+    void operator()(NodeType* node) const {
+        node->~NodeType();
+        resource->deallocate(node, sizeof(NodeType), alignof(NodeType));
+    }
+};
+
+class CsrGraph;
+
+// Graph over id, edge weight and label types. Member definitions live in graph.cpp and are explicitly instantiated
+// for ids uint32_t/uint64_t, weights uint8_t/uint32_t/float, labels uint8_t/uint16_t/uint32_t and the int default.
+template <typename IdType = int, typename WeightType = int, typename LabelType = int>
+class BasicGraph {
+    public:
+        typedef BasicNode<IdType, WeightType, LabelType> NodeType;
+        typedef unique_ptr<NodeType, NodeDeleter<NodeType>> NodePtr;
+
+    private:
+        // Graph-scoped pool backing nodes, edge lists and edge indices. Declared before nodes so it
+        // outlives them, and heap allocated so its address survives moves.
+        unique_ptr<pmr::unsynchronized_pool_resource> memoryPool;
+        // Sum of weights over all edge entries, kept in sync by the Graph edge and node methods
+        WeightSum<WeightType> directedEdgeWeight = 0;
+        // Label to member nodes, kept in sync by setLabel and the node methods. Members are unordered and removal
+        // swaps the last member into the freed slot; empty communities are dropped.
+        unordered_map<LabelType, vector<NodeType*>> communityMembers;
+
+        // Edge entries below which copies and snapshot construction stay on one thread
+        static const size_t parallelEntries = 1 << 16;
+
+        pmr::memory_resource* getMemoryResource();
+        NodePtr createNode(IdType nodeId, LabelType nodeLabel);
+        NodeType* appendNode(NodePtr node);
+        void copyNodes(const BasicGraph& other);
+        void buildHubIndices();
+        template <typename EntriesOf, typename Body, typename Side>
+        void forEachNodeRange(EntriesOf entriesOf, Body body, Side side);
+        template <typename EntriesOf, typename Body>
+        void forEachNodeRange(EntriesOf entriesOf, Body body);
+        vector<size_t> getNodeOrder(NodeOrder order) const;
+        vector<size_t> getReverseCuthillMcKeeOrder() const;
+        void indexLabel(NodeType* node);
+        void unindexLabel(NodeType* node);
+        void rebuildCommunityIndex();
+
     public:
         // Constructors
-        explicit Graph(int numberNodes);
-        ~Graph();
+        // numberNodes nodes with ids 0..numberNodes-1, each in its own community. Throws invalid_argument when the
+        // labels don't fit LabelType.
+        explicit BasicGraph(size_t numberNodes);
+        explicit BasicGraph(const CsrGraph& snapshot);
+        ~BasicGraph();
 
         // Move constructor and assignment operator
-        Graph(Graph&& other) noexcept;
-        Graph& operator=(Graph&& other) noexcept;
+        BasicGraph(BasicGraph&& other) noexcept;
+        BasicGraph& operator=(BasicGraph&& other) noexcept;
 
         // Copy constructor and assignment operator
-        Graph(const Graph& other);
-        Graph& operator=(const Graph& other);
+        BasicGraph(const BasicGraph& other);
+        BasicGraph& operator=(const BasicGraph& other);
 
-        // TODO: need to move nodes to unordered_map(possibly would remove id_to_index_mapping)
-        vector<unique_ptr<Node>> nodes;
-        unordered_map<int, size_t> id_to_index_mapping;
+        // Dense node storage, removeNode moves the last node into the freed slot so node order is not stable.
+        // Edges should be added through Graph rather than Node::addEdge so total edge weight stays in sync.
+        vector<NodePtr> nodes;
+        unordered_map<IdType, size_t> id_to_index_mapping;
 
         void draw(const string &filepath);
-        string getEdgeColor(int srcLabel, int destLabel);
-        string getNodeColor(int nodeLabel);
-        int getTotalEdges() const;
-        void addUndirectedEdge(Node* srcNode, Node* destNode, int edgeWeight = 1);
-        void addUndirectedEdge(int srcNodeId, int destNodeId, int edgeWeight = 1);
-        void removeEdge(int srcNodeId, int destNodeId);
-        void removeUndirectedEdge(int srcNodeId, int destNodeId);
-        int getEdgeWeight(int srcNodeId, int destNodeId);
-        void addNode(int nodeId, int nodeLabel);
-        void removeNode(int nodeId);
-        const Node* getNode(int nodeId) const;
-        Node* getNode(int nodeId);
-        unordered_map<int, int> getLabels() const;
-        unordered_map<int, set<int>> getCommunities() const;
+        string getEdgeColor(LabelType srcLabel, LabelType destLabel);
+        string getNodeColor(LabelType nodeLabel);
+        WeightSum<WeightType> getTotalEdges() const;
+        void addEdge(NodeType* srcNode, NodeType* destNode, WeightType edgeWeight = 1);
+        void addUndirectedEdge(NodeType* srcNode, NodeType* destNode, WeightType edgeWeight = 1);
+        void addUndirectedEdge(IdType srcNodeId, IdType destNodeId, WeightType edgeWeight = 1);
+        void addEdgesBulk(const vector<pair<IdType, IdType>>& edges, const vector<WeightType>& edgeWeights = {}, bool parallel = false);
+        void removeEdge(IdType srcNodeId, IdType destNodeId);
+        void removeUndirectedEdge(IdType srcNodeId, IdType destNodeId);
+        WeightType getEdgeWeight(IdType srcNodeId, IdType destNodeId);
+        void addNode(IdType nodeId, LabelType nodeLabel);
+        void removeNode(IdType nodeId);
+        void reorderNodes(NodeOrder order);
+        const NodeType* getNode(IdType nodeId) const;
+        NodeType* getNode(IdType nodeId);
+        void setLabel(NodeType* node, LabelType nodeLabel);
+        void setLabel(IdType nodeId, LabelType nodeLabel);
+        const unordered_map<LabelType, vector<NodeType*>>& getCommunityMembers() const;
+        const vector<NodeType*>& getCommunity(LabelType nodeLabel) const;
+        size_t numberCommunities() const;
+        unordered_map<IdType, LabelType> getLabels() const;
+        unordered_map<LabelType, set<IdType>> getCommunities() const;
 };
 
+// Default instantiation used by the algorithms
+typedef BasicNode<> Node;
+typedef BasicGraph<> Graph;
+typedef Graph::NodePtr NodePtr;
+
+// Dense layout for graphs with few communities, and 64 bit ids for graphs beyond 2^32 nodes
+typedef BasicGraph<uint32_t, uint32_t, uint8_t> CompactGraph;
+typedef BasicGraph<uint64_t, uint32_t, uint32_t> LargeGraph;
+
 #endif // GRAPH_H
@@ -2,20 +2,45 @@
 
 
 IPSolver::IPSolver(
-    Graph graph,
+    const Graph& graph,
     int numberCommunities,
-    vector<pair<int, int>> addedEdges,
-    vector<pair<int, int>> removedEdges
+    const vector<pair<int, int>>& addedEdges,
+    const vector<pair<int, int>>& removedEdges,
+    NodeOrder nodeOrder
 ):
     ip_graph(graph),
     numberCommunities(numberCommunities),
     total_edges(graph.getTotalEdges())
 {
     // Add edges
-    for (const auto& [src_id, dest_id]: addedEdges) {
-        ip_graph.addUndirectedEdge(src_id, dest_id);
-        total_edges += 1;
+    ip_graph.addEdgesBulk(addedEdges);
+    total_edges = ip_graph.getTotalEdges();
+    ip_graph.reorderNodes(nodeOrder);
+
+    // Solve the ILP
+    solveIP();
+}
+
+IPSolver::IPSolver(
+    const Graph& graph,
+    int numberCommunities,
+    EdgeStream& events,
+    NodeOrder nodeOrder
+):
+    ip_graph(graph),
+    numberCommunities(numberCommunities),
+    total_edges(graph.getTotalEdges())
+{
+    EdgeEvent event;
+    while (events.next(event)) {
+        if (event.op == EdgeOp::Add) {
+            ip_graph.addUndirectedEdge(event.src, event.dest);
+        } else {
+            ip_graph.removeUndirectedEdge(event.src, event.dest);
+        }
     }
+    total_edges = ip_graph.getTotalEdges();
+    ip_graph.reorderNodes(nodeOrder);
 
     // Solve the ILP
     solveIP();
@@ -185,7 +210,6 @@ void IPSolver::updateNodeLabels(unordered_map<string, MPVariable*>& Xuv) {
 
     // Assign the community labels to the nodes
     for (const auto& pair : nodeToCluster) {
-        Node* node = ip_graph.getNode(pair.first);
-        node->label = pair.second;
+        ip_graph.setLabel(pair.first, pair.second);
     }
 }
@@ -6,6 +6,7 @@
 #include "ip_solver.h"
 #include "scripts/overall_run.h"
 #include "scripts/self_run.h"
+#include "scripts/hub_benchmark.h"
 
 using namespace std;
 
@@ -14,15 +15,21 @@ using namespace std;
 void displayHelp() {
     cout << "Usage: ./main [options]\n"
         << "Options:\n"
-        << "  -f, --filename [string]  Specify the filename"
+        << "  -f, --filename [string]  Specify the filename\n"
+        << "  -e, --edges [string]  Read edge events from a text or binary file, - for stdin\n"
+        << "  -c, --convert_test_data  Write binary graph and edge event files for the test data\n"
+        << "  -b, --hub_benchmark   Time hub adjacency on heavy-tailed Chung-Lu graphs\n"
         << "  -h, --help            Display this help message\n";
 }
 
 int main(int argc, char* argv[]) {
     string filename = "default.json";
+    string edges_path = "";
     bool test_script = false;
     bool draw_graphs = false;
     bool self_script = false;
+    bool convert_data = false;
+    bool hub_benchmark = false;
 
     // Parse command-line arguments
     for (int i = 1; i < argc; ++i) {
@@ -34,12 +41,24 @@ int main(int argc, char* argv[]) {
                 cerr << "Error: --filename or -f requires a string as an argument.\n";
                 return 1;
             }
+        } else if (strcmp(argv[i], "-e") == 0 || strcmp(argv[i], "--edges") == 0) {
+            if (i+1 < argc) {
+                edges_path = argv[i + 1];
+                ++i;
+            } else {
+                cerr << "Error: --edges or -e requires a path or - as an argument.\n";
+                return 1;
+            }
         } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--test_script") == 0) {
             test_script = true;
         } else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--self_script") == 0) {
             self_script = true;
         } else if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--draw_graphs") == 0) {
             draw_graphs = true;
+        } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--convert_test_data") == 0) {
+            convert_data = true;
+        } else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--hub_benchmark") == 0) {
+            hub_benchmark = true;
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             displayHelp();
             return 0;
@@ -50,6 +69,16 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (convert_data) {
+        convert_test_data();
+        return 0;
+    }
+
+    if (hub_benchmark) {
+        run_hub_benchmark();
+        return 0;
+    }
+
     if (test_script) {
         // Run the overall script
         run_all_algorithms(draw_graphs);
@@ -62,10 +91,29 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    generated_sequence gs = generateSequence(filename);
+    generated_sequence gs = generateSequence(filename, false);
+    if (gs.algorithm_number == 3 && (!gs.workload.isStatic() || !gs.evolution.isStatic())) {
+        // Churn and evolving streams remove edges, which ACD can't handle
+        cerr << "Error: algorithm 3 does not support workloads that remove edges.\n";
+        return 1;
+    }
+
+    // Edges are pulled from the stream as the algorithm runs instead of being generated up front
+    unique_ptr<EdgeStream> events;
+    if (!edges_path.empty()) {
+        events = openEdgeStream(edges_path);
+    } else if (gs.fullInstance) {
+        events = make_unique<SbmInstanceStream>(gs.sbm);
+    } else if (!gs.evolution.isStatic()) {
+        events = make_unique<EvolvingSbmStream>(gs.sbm, gs.workload, gs.evolution);
+    } else if (!gs.workload.isStatic()) {
+        events = make_unique<WorkloadEdgeStream>(gs.sbm, gs.workload);
+    } else {
+        events = make_unique<SbmEdgeStream>(gs.sbm, gs.numberEdges);
+    }
 
     if (gs.algorithm_number == 1) {
-        DynamicCommunityDetection dcd(gs.sbm.sbm_graph, gs.sbm.numberCommunities, gs.addedEdges, gs.removedEdges);
+        DynamicCommunityDetection dcd(gs.sbm.sbm_graph, gs.sbm.numberCommunities, *events, gs.nodeOrder);
         unordered_map<int, int> predicted_labels = dcd.c_ll.getLabels();
         for (const auto& label: predicted_labels) {
             cout << "Node: " << label.first << " Community: " << label.second << endl;
@@ -78,8 +126,9 @@ int main(int argc, char* argv[]) {
             gs.radius,
             gs.sbm.intraCommunityEdgeProbability,
             gs.sbm.interCommunityEdgeProbability,
-            gs.addedEdges,
-            gs.removedEdges
+            *events,
+            gs.nodeOrder,
+            gs.messageScaling
         );
         unordered_map<int, int> predicted_labels = bp.bp_graph.getLabels();
         for (const auto& label: predicted_labels) {
@@ -87,14 +136,14 @@ int main(int argc, char* argv[]) {
         }
         bp.bp_graph.draw(TEST_OUTPUT_DIRECTORY + string("/predicted_graph.png"));
     } else if (gs.algorithm_number == 3) {
-        ApproximateCommunityDetection acd(gs.sbm.sbm_graph, gs.sbm.numberCommunities, gs.addedEdges, gs.removedEdges);
+        ApproximateCommunityDetection acd(gs.sbm.sbm_graph, gs.sbm.numberCommunities, *events, -1, nullptr, gs.nodeOrder);
         unordered_map<int, int> predicted_labels = acd.acd_graph.getLabels();
         for (const auto& label: predicted_labels) {
             cout << "Node: " << label.first << " Community: " << label.second << endl;
         }
         acd.acd_graph.draw(TEST_OUTPUT_DIRECTORY + string("/predicted_graph.png"));
     } else if (gs.algorithm_number == 4) {
-        IPSolver ip_solver(gs.sbm.sbm_graph, gs.sbm.numberCommunities, gs.addedEdges, gs.removedEdges);
+        IPSolver ip_solver(gs.sbm.sbm_graph, gs.sbm.numberCommunities, *events, gs.nodeOrder);
         unordered_map<int, int> predicted_labels = ip_solver.ip_graph.getLabels();
         for (const auto& label: predicted_labels) {
             cout << "Node: " << label.first << " Community: " << label.second << endl;
@@ -0,0 +1,33 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+MappedFile::MappedFile(const string& filepath): address(nullptr), length(0) {
+    int fileDescriptor = open(filepath.c_str(), O_RDONLY);
+    if (fileDescriptor == -1) {
+        throw runtime_error("Unable to open file " + filepath);
+    }
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) == -1 || fileStatus.st_size == 0) {
+        close(fileDescriptor);
+        throw runtime_error("File " + filepath + " is empty or unreadable");
+    }
+    length = fileStatus.st_size;
+
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    // The mapping keeps its own reference to the file
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+        throw runtime_error("Unable to map file " + filepath);
+    }
+    address = static_cast<const char*>(mapping);
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<char*>(address), length);
+}
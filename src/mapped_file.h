@@ -0,0 +1,28 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+
+using namespace std;
+
+
+// Read-only private memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+    public:
+        explicit MappedFile(const string& filepath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const { return address; }
+        size_t size() const { return length; }
+
+    private:
+        const char* address;
+        size_t length;
+};
+
+#endif // MAPPED_FILE_H
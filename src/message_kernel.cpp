@@ -0,0 +1,332 @@
+#include "message_kernel.h"
+
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MESSAGE_KERNEL_X86
+#endif
+
+
+namespace {
+    void multiplyScalar(double* result, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference) {
+        for (size_t edge = 0; edge < edgeCount; ++edge) {
+            const double* message = messages + size_t(edgeIds[edge]) * count;
+            for (int s = 0; s < count; ++s) {
+                result[s] *= (inter + difference * message[s]) * prior[s];
+            }
+        }
+    }
+
+    void rescaleScalar(double* result, int64_t* exponents, int count) {
+        for (int s = 0; s < count; ++s) {
+            // Same as the vector kernels: zeros and subnormals stay as they are, everything else moves to [1, 2)
+            if (isnormal(result[s])) {
+                int shift;
+                result[s] = 2 * frexp(result[s], &shift);
+                exponents[s] += shift - 1;
+            }
+        }
+    }
+
+    void multiplyRescaledScalar(double* result, int64_t* exponents, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference, size_t interval) {
+        for (size_t begin = 0; begin < edgeCount; begin += interval) {
+            rescaleScalar(result, exponents, count);
+            multiplyScalar(result, messages, edgeIds + begin, min(interval, edgeCount - begin), prior, count, inter, difference);
+        }
+        rescaleScalar(result, exponents, count);
+    }
+
+    void normalizeScalar(double* values, int count) {
+        double Z = accumulate(values, values + count, 0.0);
+        if (Z != 0) {
+            for (int s = 0; s < count; ++s) {
+                values[s] /= Z;
+            }
+        }
+    }
+
+#ifdef MESSAGE_KERNEL_X86
+    // Lane mask of the first remaining components of a partial AVX2 vector
+    __attribute__((target("avx2")))
+    __m256i tailMask(int remaining) {
+        return _mm256_cmpgt_epi64(_mm256_set1_epi64x(remaining), _mm256_setr_epi64x(0, 1, 2, 3));
+    }
+
+    // Vector kernels walk the messages once per group of lanes, so the partial product and the prior stay in
+    // registers across all messages. Each component still sees the messages in the same order as the scalar loop.
+    // This file is built with -ffp-contract=off, otherwise the avx512f target lets GCC fuse the multiply and add into
+    // an FMA with a different rounding than the scalar loop.
+    __attribute__((target("avx2")))
+    inline __m256d foldAvx2(__m256d product, __m256d priorLanes, __m256i mask, const double* messages, const int* edgeIds, size_t edgeCount, int count, double inter, double difference) {
+        const __m256d interLanes = _mm256_set1_pd(inter);
+        const __m256d differenceLanes = _mm256_set1_pd(difference);
+        for (size_t edge = 0; edge < edgeCount; ++edge) {
+            const double* message = messages + size_t(edgeIds[edge]) * count;
+            __m256d factor = _mm256_add_pd(interLanes, _mm256_mul_pd(differenceLanes, _mm256_maskload_pd(message, mask)));
+            product = _mm256_mul_pd(product, _mm256_mul_pd(factor, priorLanes));
+        }
+        return product;
+    }
+
+    __attribute__((target("avx2")))
+    void multiplyAvx2(double* result, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference) {
+        for (int s = 0; s < count; s += 4) {
+            __m256i mask = tailMask(count - s);
+            __m256d product = _mm256_maskload_pd(result + s, mask);
+            __m256d priorLanes = _mm256_maskload_pd(prior + s, mask);
+            product = foldAvx2(product, priorLanes, mask, messages + s, edgeIds, edgeCount, count, inter, difference);
+            _mm256_maskstore_pd(result + s, mask, product);
+        }
+    }
+
+    // Moves the exponent of every normal lane into exponent and leaves a mantissa in [1, 2)
+    __attribute__((target("avx2")))
+    inline void rescaleAvx2(__m256d& product, __m256i& exponent) {
+        const __m256i exponentBits = _mm256_set1_epi64x(0x7FF0000000000000LL);
+        __m256i bits = _mm256_castpd_si256(product);
+        __m256i biased = _mm256_srli_epi64(_mm256_and_si256(bits, exponentBits), 52);
+        __m256i normal = _mm256_cmpgt_epi64(biased, _mm256_setzero_si256());
+        __m256i mantissa = _mm256_or_si256(_mm256_andnot_si256(exponentBits, bits), _mm256_set1_epi64x(0x3FF0000000000000LL));
+        product = _mm256_blendv_pd(product, _mm256_castsi256_pd(mantissa), _mm256_castsi256_pd(normal));
+        exponent = _mm256_add_epi64(exponent, _mm256_and_si256(normal, _mm256_sub_epi64(biased, _mm256_set1_epi64x(1023))));
+    }
+
+    __attribute__((target("avx2")))
+    void multiplyRescaledAvx2(double* result, int64_t* exponents, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference, size_t interval) {
+        for (int s = 0; s < count; s += 4) {
+            __m256i mask = tailMask(count - s);
+            __m256d product = _mm256_maskload_pd(result + s, mask);
+            __m256i exponent = _mm256_maskload_epi64(reinterpret_cast<const long long*>(exponents + s), mask);
+            __m256d priorLanes = _mm256_maskload_pd(prior + s, mask);
+            for (size_t begin = 0; begin < edgeCount; begin += interval) {
+                rescaleAvx2(product, exponent);
+                product = foldAvx2(product, priorLanes, mask, messages + s, edgeIds + begin, min(interval, edgeCount - begin), count, inter, difference);
+            }
+            rescaleAvx2(product, exponent);
+            _mm256_maskstore_pd(result + s, mask, product);
+            _mm256_maskstore_epi64(reinterpret_cast<long long*>(exponents + s), mask, exponent);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void normalizeAvx2(double* values, int count) {
+        __m256d sum = _mm256_setzero_pd();
+        for (int s = 0; s < count; s += 4) {
+            sum = _mm256_add_pd(sum, _mm256_maskload_pd(values + s, tailMask(count - s)));
+        }
+        __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+        double Z = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+        if (Z == 0) {
+            return;
+        }
+
+        const __m256d ZLanes = _mm256_set1_pd(Z);
+        for (int s = 0; s < count; s += 4) {
+            __m256i mask = tailMask(count - s);
+            _mm256_maskstore_pd(values + s, mask, _mm256_div_pd(_mm256_maskload_pd(values + s, mask), ZLanes));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    __mmask8 laneMask(int remaining) {
+        return (remaining >= 8) ? 0xFF : __mmask8((1u << remaining) - 1);
+    }
+
+    __attribute__((target("avx512f")))
+    inline __m512d foldAvx512(__m512d product, __m512d priorLanes, __mmask8 mask, const double* messages, const int* edgeIds, size_t edgeCount, int count, double inter, double difference) {
+        const __m512d interLanes = _mm512_set1_pd(inter);
+        const __m512d differenceLanes = _mm512_set1_pd(difference);
+        for (size_t edge = 0; edge < edgeCount; ++edge) {
+            const double* message = messages + size_t(edgeIds[edge]) * count;
+            __m512d factor = _mm512_add_pd(interLanes, _mm512_mul_pd(differenceLanes, _mm512_maskz_loadu_pd(mask, message)));
+            product = _mm512_mul_pd(product, _mm512_mul_pd(factor, priorLanes));
+        }
+        return product;
+    }
+
+    __attribute__((target("avx512f")))
+    void multiplyAvx512(double* result, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference) {
+        for (int s = 0; s < count; s += 8) {
+            __mmask8 mask = laneMask(count - s);
+            __m512d product = _mm512_maskz_loadu_pd(mask, result + s);
+            __m512d priorLanes = _mm512_maskz_loadu_pd(mask, prior + s);
+            product = foldAvx512(product, priorLanes, mask, messages + s, edgeIds, edgeCount, count, inter, difference);
+            _mm512_mask_storeu_pd(result + s, mask, product);
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    inline void rescaleAvx512(__m512d& product, __m512i& exponent) {
+        const __m512i exponentBits = _mm512_set1_epi64(0x7FF0000000000000LL);
+        __m512i bits = _mm512_castpd_si512(product);
+        __m512i biased = _mm512_srli_epi64(_mm512_and_si512(bits, exponentBits), 52);
+        __mmask8 normal = _mm512_cmpgt_epi64_mask(biased, _mm512_setzero_si512());
+        __m512i mantissa = _mm512_or_si512(_mm512_andnot_si512(exponentBits, bits), _mm512_set1_epi64(0x3FF0000000000000LL));
+        product = _mm512_mask_blend_pd(normal, product, _mm512_castsi512_pd(mantissa));
+        exponent = _mm512_mask_add_epi64(exponent, normal, exponent, _mm512_sub_epi64(biased, _mm512_set1_epi64(1023)));
+    }
+
+    __attribute__((target("avx512f")))
+    void multiplyRescaledAvx512(double* result, int64_t* exponents, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference, size_t interval) {
+        for (int s = 0; s < count; s += 8) {
+            __mmask8 mask = laneMask(count - s);
+            __m512d product = _mm512_maskz_loadu_pd(mask, result + s);
+            __m512i exponent = _mm512_maskz_loadu_epi64(mask, exponents + s);
+            __m512d priorLanes = _mm512_maskz_loadu_pd(mask, prior + s);
+            for (size_t begin = 0; begin < edgeCount; begin += interval) {
+                rescaleAvx512(product, exponent);
+                product = foldAvx512(product, priorLanes, mask, messages + s, edgeIds + begin, min(interval, edgeCount - begin), count, inter, difference);
+            }
+            rescaleAvx512(product, exponent);
+            _mm512_mask_storeu_pd(result + s, mask, product);
+            _mm512_mask_storeu_epi64(exponents + s, mask, exponent);
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void normalizeAvx512(double* values, int count) {
+        __m512d sum = _mm512_setzero_pd();
+        for (int s = 0; s < count; s += 8) {
+            sum = _mm512_add_pd(sum, _mm512_maskz_loadu_pd(laneMask(count - s), values + s));
+        }
+        double Z = _mm512_reduce_add_pd(sum);
+        if (Z == 0) {
+            return;
+        }
+
+        const __m512d ZLanes = _mm512_set1_pd(Z);
+        for (int s = 0; s < count; s += 8) {
+            __mmask8 mask = laneMask(count - s);
+            _mm512_mask_storeu_pd(values + s, mask, _mm512_div_pd(_mm512_maskz_loadu_pd(mask, values + s), ZLanes));
+        }
+    }
+#endif
+}
+
+// Messages lie in [0, 1], so every factor lies between the factors of the two end points. A normal double has
+// about 1000 bits of exponent to either side of 1, the interval is the number of factors that fit into that.
+size_t messageRescaleInterval(const double* prior, int count, double inter, double difference) {
+    double lowestPrior = INFINITY;
+    double highestPrior = 0;
+    for (int s = 0; s < count; ++s) {
+        // Zero priors give exact zeros, which the rescaling leaves alone
+        if (prior[s] > 0) {
+            lowestPrior = min(lowestPrior, prior[s]);
+        }
+        highestPrior = max(highestPrior, prior[s]);
+    }
+    double low = min(inter, inter + difference) * lowestPrior;
+    double high = max(inter, inter + difference) * highestPrior;
+    double bitsPerFactor = (low > 0) ? max({1.0, -log2(low), log2(high)}) : INFINITY;
+    return max(size_t(1), size_t(1000 / bitsPerFactor));
+}
+
+bool messageKernelSupported(MessageKernel kernel) {
+#ifdef MESSAGE_KERNEL_X86
+    static const bool hasAvx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    static const bool hasAvx512 = (__builtin_cpu_init(), __builtin_cpu_supports("avx512f"));
+    switch (kernel) {
+        case MessageKernel::Scalar:
+            return true;
+        case MessageKernel::Avx2:
+            return hasAvx2;
+        case MessageKernel::Avx512:
+            return hasAvx512;
+    }
+    return false;
+#else
+    return kernel == MessageKernel::Scalar;
+#endif
+}
+
+MessageKernel bestMessageKernel() {
+    for (MessageKernel kernel: {MessageKernel::Avx512, MessageKernel::Avx2}) {
+        if (messageKernelSupported(kernel)) {
+            return kernel;
+        }
+    }
+    return MessageKernel::Scalar;
+}
+
+const char* messageKernelName(MessageKernel kernel) {
+    switch (kernel) {
+        case MessageKernel::Avx2:
+            return "avx2";
+        case MessageKernel::Avx512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+void multiplyMessages(MessageKernel kernel, double* result, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference) {
+#ifdef MESSAGE_KERNEL_X86
+    if (kernel == MessageKernel::Avx512) {
+        multiplyAvx512(result, messages, edgeIds, edgeCount, prior, count, inter, difference);
+        return;
+    }
+    if (kernel == MessageKernel::Avx2) {
+        multiplyAvx2(result, messages, edgeIds, edgeCount, prior, count, inter, difference);
+        return;
+    }
+#endif
+    multiplyScalar(result, messages, edgeIds, edgeCount, prior, count, inter, difference);
+}
+
+void normalizeMessage(MessageKernel kernel, double* values, int count) {
+#ifdef MESSAGE_KERNEL_X86
+    if (kernel == MessageKernel::Avx512) {
+        normalizeAvx512(values, count);
+        return;
+    }
+    if (kernel == MessageKernel::Avx2) {
+        normalizeAvx2(values, count);
+        return;
+    }
+#endif
+    normalizeScalar(values, count);
+}
+
+void multiplyMessagesRescaled(MessageKernel kernel, double* result, int64_t* exponents, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference, size_t interval) {
+    if (edgeCount == 0) {
+        return;
+    }
+#ifdef MESSAGE_KERNEL_X86
+    if (kernel == MessageKernel::Avx512) {
+        multiplyRescaledAvx512(result, exponents, messages, edgeIds, edgeCount, prior, count, inter, difference, interval);
+        return;
+    }
+    if (kernel == MessageKernel::Avx2) {
+        multiplyRescaledAvx2(result, exponents, messages, edgeIds, edgeCount, prior, count, inter, difference, interval);
+        return;
+    }
+#endif
+    multiplyRescaledScalar(result, exponents, messages, edgeIds, edgeCount, prior, count, inter, difference, interval);
+}
+
+void normalizeRescaledMessage(MessageKernel kernel, double* values, int64_t* exponents, int count) {
+    int64_t largest = INT64_MIN;
+    for (int s = 0; s < count; ++s) {
+        if (values[s] != 0) {
+            largest = max(largest, exponents[s]);
+        }
+    }
+
+    // Mantissas lie in [1, 2), so components whose scale would be subnormal are 0 after normalization anyway. The
+    // scale is built from its exponent bits, ldexp per component costs more than the whole fold at small degrees.
+    for (int s = 0; s < count; ++s) {
+        // Zeros keep whatever exponent they started with, they are left at a scale of 1
+        int64_t shift = (values[s] != 0) ? exponents[s] - largest : 0;
+        uint64_t scaleBits = (shift > -1023) ? uint64_t(shift + 1023) << 52 : 0;
+        double scale;
+        memcpy(&scale, &scaleBits, sizeof(scale));
+        values[s] *= scale;
+        exponents[s] = 0;
+    }
+    normalizeMessage(kernel, values, count);
+}
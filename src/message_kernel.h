@@ -0,0 +1,42 @@
+#ifndef MESSAGE_KERNEL_H
+#define MESSAGE_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+
+// Vector kernels of the StreamBP message update. Callers pick one once with bestMessageKernel(). Products are
+// the same for every kernel, normalized values only differ by the summation order.
+enum class MessageKernel { Scalar, Avx2, Avx512 };
+
+// Product multiplies the factors straight into the message, which underflows to 0 on high degree nodes. Rescaled
+// keeps every component as a mantissa times 2^exponent and moves powers of two into the exponent as it goes.
+enum class MessageScaling { Product, Rescaled };
+
+MessageKernel bestMessageKernel();
+bool messageKernelSupported(MessageKernel kernel);
+const char* messageKernelName(MessageKernel kernel);
+
+// Folds the messages with the given ids into result, message i starting at messages + i * count:
+// result[s] *= (inter + difference * message[s]) * prior[s] for all count components, with difference the intra minus
+// inter community edge probability. The kernel has to be supported by the CPU.
+void multiplyMessages(MessageKernel kernel, double* result, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference);
+
+// Divides values by their sum, values summing to 0 are left as they are
+void normalizeMessage(MessageKernel kernel, double* values, int count);
+
+// Number of factors that can be multiplied into a rescaled product before it may leave the normal range, for message
+// components in [0, 1]. Only depends on the prior and the edge probabilities, so callers compute it once per prior.
+size_t messageRescaleInterval(const double* prior, int count, double inter, double difference);
+
+// Same fold as multiplyMessages on the rescaled form result[s] * 2^exponents[s], rescaling after every interval
+// messages. Rescaling only moves powers of two, so the mantissas are the same as in the plain product wherever that
+// one does not underflow.
+void multiplyMessagesRescaled(MessageKernel kernel, double* result, int64_t* exponents, const double* messages, const int* edgeIds, size_t edgeCount, const double* prior, int count, double inter, double difference, size_t interval);
+
+// Brings a rescaled message back to plain values relative to its largest exponent and normalizes it
+void normalizeRescaledMessage(MessageKernel kernel, double* values, int64_t* exponents, int count);
+
+#endif // MESSAGE_KERNEL_H
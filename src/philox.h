@@ -0,0 +1,81 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+using namespace std;
+
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"). Output is a
+// pure function of key and counter, so every stream can be generated on its own thread without shared state. Kept
+// inline in the header since it sits in the inner loop of the generators.
+class Philox4x32 {
+    public:
+        typedef array<uint32_t, 4> Counter;
+
+        static Counter generate(Counter counter, uint64_t key) {
+            uint32_t key0 = static_cast<uint32_t>(key);
+            uint32_t key1 = static_cast<uint32_t>(key >> 32);
+            for (int round = 0; round < 10; ++round) {
+                uint64_t product0 = static_cast<uint64_t>(multiplier0) * counter[0];
+                uint64_t product1 = static_cast<uint64_t>(multiplier1) * counter[2];
+                counter = {
+                    static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key0,
+                    static_cast<uint32_t>(product1),
+                    static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key1,
+                    static_cast<uint32_t>(product0)
+                };
+                key0 += weyl0;
+                key1 += weyl1;
+            }
+            return counter;
+        }
+
+    private:
+        static const uint32_t multiplier0 = 0xD2511F53;
+        static const uint32_t multiplier1 = 0xCD9E8D57;
+        static const uint32_t weyl0 = 0x9E3779B9;
+        static const uint32_t weyl1 = 0xBB67AE85;
+};
+
+// Sequence of 64 bit values for one (key, stream id) pair, the stream id fills the upper half of the counter and the
+// position the lower half. Satisfies UniformRandomBitGenerator.
+class PhiloxStream {
+    public:
+        typedef uint64_t result_type;
+
+        PhiloxStream(uint64_t key, uint64_t streamId): key(key), streamId(streamId), position(0), used(2) {}
+
+        static constexpr uint64_t min() { return 0; }
+        static constexpr uint64_t max() { return numeric_limits<uint64_t>::max(); }
+
+        uint64_t operator()() {
+            if (used == 2) {
+                block = Philox4x32::generate({
+                    static_cast<uint32_t>(position), static_cast<uint32_t>(position >> 32),
+                    static_cast<uint32_t>(streamId), static_cast<uint32_t>(streamId >> 32)
+                }, key);
+                position++;
+                used = 0;
+            }
+            uint64_t value = (static_cast<uint64_t>(block[2 * used + 1]) << 32) | block[2 * used];
+            used++;
+            return value;
+        }
+
+        // Uniform in [0, 1) from the top 53 bits, independent of the standard library's distributions
+        double uniform() {
+            return ((*this)() >> 11) * 0x1.0p-53;
+        }
+
+    private:
+        uint64_t key;
+        uint64_t streamId;
+        uint64_t position;
+        Philox4x32::Counter block;
+        int used;
+};
+
+#endif // PHILOX_H
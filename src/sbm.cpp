@@ -1,31 +1,59 @@
 #include "sbm.h"
 #include <ctime>
 #include <algorithm>
-#include <unordered_set>
+#include <numeric>
+#include <cmath>
+#include <atomic>
+#include <thread>
 
 Sbm::Sbm(
     int numberNodes,
     int numberCommunities,
     double intraCommunityEdgeProbability,
-    double interCommunityEdgeProbability
+    double interCommunityEdgeProbability,
+    uint64_t seed
+): Sbm(numberNodes, vector<int>(numberCommunities, numberNodes / numberCommunities), intraCommunityEdgeProbability, interCommunityEdgeProbability, seed, {}) {}
+
+Sbm::Sbm(
+    const vector<int>& blockSizes,
+    double intraCommunityEdgeProbability,
+    double interCommunityEdgeProbability,
+    uint64_t seed,
+    const vector<double>& propensities
+): Sbm(accumulate(blockSizes.begin(), blockSizes.end(), 0), blockSizes, intraCommunityEdgeProbability, interCommunityEdgeProbability, seed, propensities) {}
+
+Sbm::Sbm(
+    int numberNodes,
+    const vector<int>& blockSizes,
+    double intraCommunityEdgeProbability,
+    double interCommunityEdgeProbability,
+    uint64_t seed,
+    const vector<double>& propensities
 ):
     numberNodes(numberNodes),
-    numberCommunities(numberCommunities),
+    seed(seed),
+    blockSizes(blockSizes),
+    propensities(propensities),
+    gen(seed),
+    boundaryDistribution(0.0, 1.0),
+    sbm_graph(0),
+    numberCommunities(blockSizes.size()),
     intraCommunityEdgeProbability(intraCommunityEdgeProbability),
-    interCommunityEdgeProbability(interCommunityEdgeProbability),
-    sbm_graph(numberNodes),
-    communityTracker(numberCommunities,
-    vector<int>(numberNodes/numberCommunities, -1)),
-    gen(random_device{}())
+    interCommunityEdgeProbability(interCommunityEdgeProbability)
 {
+    if (blockSizes.empty() || *min_element(blockSizes.begin(), blockSizes.end()) < 1) {
+        throw invalid_argument("Sbm: Expected at least one block, each with at least one node.");
+    }
+    if (!propensities.empty() && propensities.size() != (size_t) numberNodes) {
+        throw invalid_argument("Sbm: Expected one propensity per node.");
+    }
+    for (int blockSize: blockSizes) {
+        communityTracker.emplace_back(blockSize, -1);
+    }
+
     // Generate graph with no edges
     sbm_graph = generateSbm();
-
-    // Calculate communityBoundaryThreshold for edge generation
-    double chooseNodesFromSameCommunity = numberCommunities * (1.0 / ((numberNodes / numberCommunities + 1) * betal(numberNodes / numberCommunities - 1, 3)));
-    double intraCommunityWeight = chooseNodesFromSameCommunity * intraCommunityEdgeProbability;
-    double interCommunityWeight = (1.0 / ((numberNodes + 1) * betal(numberNodes - 1, 3)) - chooseNodesFromSameCommunity) * interCommunityEdgeProbability;
-    communityBoundaryThreshold = intraCommunityWeight / (interCommunityWeight + intraCommunityWeight);
+    buildEdgeTables();
 }
 
 Sbm::~Sbm() {
@@ -35,29 +63,137 @@ Sbm::~Sbm() {
 // Move constructor
 Sbm::Sbm(Sbm&& other) noexcept
     : numberNodes(other.numberNodes),
-        numberCommunities(other.numberCommunities),
-        intraCommunityEdgeProbability(other.intraCommunityEdgeProbability),
-        interCommunityEdgeProbability(other.interCommunityEdgeProbability),
+        seed(other.seed),
         communityBoundaryThreshold(other.communityBoundaryThreshold),
+        blockSizes(move(other.blockSizes)),
         communityTracker(move(other.communityTracker)),
+        propensities(move(other.propensities)),
         gen(move(other.gen)),
-        sbm_graph(move(other.sbm_graph)) {}
+        boundaryDistribution(other.boundaryDistribution),
+        intraCommunityTable(move(other.intraCommunityTable)),
+        interCommunityTable(move(other.interCommunityTable)),
+        interCommunityPairs(move(other.interCommunityPairs)),
+        memberTables(move(other.memberTables)),
+        samplingChunks(move(other.samplingChunks)),
+        sbm_graph(move(other.sbm_graph)),
+        numberCommunities(other.numberCommunities),
+        intraCommunityEdgeProbability(other.intraCommunityEdgeProbability),
+        interCommunityEdgeProbability(other.interCommunityEdgeProbability) {}
 
 // Move assignment operator
 Sbm& Sbm::operator=(Sbm&& other) noexcept {
     if (this != &other) {
         numberNodes = other.numberNodes;
+        seed = other.seed;
         numberCommunities = other.numberCommunities;
         intraCommunityEdgeProbability = other.intraCommunityEdgeProbability;
         interCommunityEdgeProbability = other.interCommunityEdgeProbability;
         communityBoundaryThreshold = other.communityBoundaryThreshold;
+        blockSizes = move(other.blockSizes);
         communityTracker = move(other.communityTracker);
+        propensities = move(other.propensities);
         gen = move(other.gen);
+        boundaryDistribution = other.boundaryDistribution;
+        intraCommunityTable = move(other.intraCommunityTable);
+        interCommunityTable = move(other.interCommunityTable);
+        interCommunityPairs = move(other.interCommunityPairs);
+        memberTables = move(other.memberTables);
+        samplingChunks = move(other.samplingChunks);
         sbm_graph = move(other.sbm_graph);
     }
     return *this;
 }
 
+vector<double> Sbm::powerLawPropensities(int numberNodes, double exponent, uint64_t seed) {
+    if (exponent <= 1.0) {
+        throw invalid_argument("Sbm: Power law exponent must be greater than 1.");
+    }
+    // Inverse transform of a Pareto tail, drawn from a Philox stream so the sequence is fixed by the seed
+    PhiloxStream stream(seed, 0);
+    vector<double> propensities(numberNodes);
+    for (double& propensity: propensities) {
+        propensity = pow(1.0 - stream.uniform(), -1.0 / (exponent - 1.0));
+    }
+    double mean = accumulate(propensities.begin(), propensities.end(), 0.0) / max(1, numberNodes);
+    for (double& propensity: propensities) {
+        propensity /= mean;
+    }
+    return propensities;
+}
+
+vector<int> Sbm::randomBlockSizes(int numberNodes, int numberCommunities, uint64_t seed) {
+    if (numberCommunities < 1 || numberNodes < numberCommunities) {
+        throw invalid_argument("Sbm: Expected between one and numberNodes blocks.");
+    }
+    vector<int> cuts(numberNodes - 1);
+    iota(cuts.begin(), cuts.end(), 1);
+    PhiloxStream stream(seed, 1);
+    shuffle(cuts.begin(), cuts.end(), stream);
+    cuts.resize(numberCommunities - 1);
+    sort(cuts.begin(), cuts.end());
+
+    vector<int> blockSizes;
+    int previous = 0;
+    for (int cut: cuts) {
+        blockSizes.push_back(cut - previous);
+        previous = cut;
+    }
+    blockSizes.push_back(numberNodes - previous);
+    return blockSizes;
+}
+
+// Block weights are the expected edge counts up to a common factor: p * (sum of pair weights inside a block) and
+// q * (product of block totals) between blocks, pair weights being 1 or the product of propensities.
+void Sbm::buildEdgeTables() {
+    vector<double> blockTotals(numberCommunities, 0.0);
+    vector<double> intraWeights(numberCommunities, 0.0);
+    memberTables.clear();
+    for (int community = 0; community < numberCommunities; ++community) {
+        double total = 0.0;
+        double squares = 0.0;
+        vector<double> memberWeights;
+        for (int node: communityTracker[community]) {
+            double weight = propensities.empty() ? 1.0 : propensities[node];
+            total += weight;
+            squares += weight * weight;
+            memberWeights.push_back(weight);
+        }
+        blockTotals[community] = total;
+        intraWeights[community] = intraCommunityEdgeProbability * (total * total - squares) / 2.0;
+        if (!propensities.empty()) {
+            memberTables.emplace_back(memberWeights);
+        }
+    }
+
+    vector<double> interWeights;
+    interCommunityPairs.clear();
+    for (int first = 0; first < numberCommunities; ++first) {
+        for (int second = first + 1; second < numberCommunities; ++second) {
+            interCommunityPairs.emplace_back(first, second);
+            interWeights.push_back(interCommunityEdgeProbability * blockTotals[first] * blockTotals[second]);
+        }
+    }
+
+    double intraCommunityWeight = accumulate(intraWeights.begin(), intraWeights.end(), 0.0);
+    double interCommunityWeight = accumulate(interWeights.begin(), interWeights.end(), 0.0);
+    communityBoundaryThreshold = (intraCommunityWeight + interCommunityWeight > 0.0) ? intraCommunityWeight / (interCommunityWeight + intraCommunityWeight) : 1.0;
+    intraCommunityTable = (intraCommunityWeight > 0.0) ? AliasTable(intraWeights) : AliasTable();
+    interCommunityTable = (interCommunityWeight > 0.0) ? AliasTable(interWeights) : AliasTable();
+
+    // Chunk layout only depends on block sizes, so chunk streams are the same for any consumer
+    samplingChunks.clear();
+    for (int first = 0; first < numberCommunities; ++first) {
+        for (int second = first; second < numberCommunities; ++second) {
+            long long firstSize = communityTracker[first].size();
+            long long secondSize = communityTracker[second].size();
+            long long candidates = (first == second) ? firstSize * (firstSize - 1) / 2 : firstSize * secondSize;
+            for (long long begin = 0; begin < candidates; begin += chunkCandidates) {
+                samplingChunks.push_back({first, second, begin, min(begin + chunkCandidates, candidates)});
+            }
+        }
+    }
+}
+
 pair<int, int> Sbm::generateEdge() {
     if (isIntraCommunityEdge()) {
         return generateIntraCommunityEdge();
@@ -65,78 +201,197 @@ pair<int, int> Sbm::generateEdge() {
     return generateInterCommunityEdge();
 }
 
-pair<int, int> Sbm::generateInterCommunityEdge() {
-    // Create a uniform distribution between communities
-    uniform_int_distribution<int> communityDistribution(0, numberCommunities - 1);
-    int community1 = communityDistribution(gen);
-    int community2;
-
-    do {
-        community2 = communityDistribution(gen);
-    } while(community1 == community2);
+int Sbm::generateOffset(int community) {
+    if (propensities.empty()) {
+        return uniform_int_distribution<int>(0, blockSizes[community] - 1)(gen);
+    }
+    return memberTables[community].sample(gen);
+}
 
-    // Create a uniform distribution between node blocks
-    uniform_int_distribution<int> nodeDistribution(0, numberNodes / numberCommunities - 1);
-    int offset1 = nodeDistribution(gen);
-    int offset2 = nodeDistribution(gen);
+pair<int, int> Sbm::generateInterCommunityEdge() {
+    if (interCommunityTable.empty()) {
+        throw runtime_error("Sbm: No inter community edges can be drawn.");
+    }
+    auto [community1, community2] = interCommunityPairs[interCommunityTable.sample(gen)];
+    int offset1 = generateOffset(community1);
+    int offset2 = generateOffset(community2);
 
     // Return node pair
     return make_pair(communityTracker[community1][offset1], communityTracker[community2][offset2]);
 }
 
 pair<int, int> Sbm::generateIntraCommunityEdge() {
-    // Create a uniform distribution between communities
-    uniform_int_distribution<int> communityDistribution(0, numberCommunities - 1);
-    int community = communityDistribution(gen);
-
-    // Create a uniform distribution between node blocks
-    uniform_int_distribution<int> nodeDistribution(0, numberNodes / numberCommunities - 1);
-    int offset1 = nodeDistribution(gen);
+    if (intraCommunityTable.empty()) {
+        throw runtime_error("Sbm: No intra community edges can be drawn.");
+    }
+    int community = intraCommunityTable.sample(gen);
+    int offset1 = generateOffset(community);
     int offset2;
-    do {
-        offset2 = nodeDistribution(gen);
-    } while(offset1 == offset2);
+    if (propensities.empty()) {
+        // Second offset comes from one value fewer and skips the first, so no rejection loop
+        offset2 = uniform_int_distribution<int>(0, blockSizes[community] - 2)(gen);
+        offset2 += (offset2 >= offset1);
+    } else {
+        // Both ends are redrawn on a collision, redrawing only the second one would favour pairs with a hub in them.
+        // Blocks with positive weight have two members of positive propensity, so this ends.
+        offset2 = generateOffset(community);
+        while (offset2 == offset1) {
+            offset1 = generateOffset(community);
+            offset2 = generateOffset(community);
+        }
+    }
 
     return make_pair(communityTracker[community][offset1], communityTracker[community][offset2]);
 }
 
 bool Sbm::isIntraCommunityEdge() {
-    // Create a uniform distribution in the range [0.0, 1.0)
-    uniform_real_distribution<double> dis(0.0, 1.0);
-
     // Return true for intra community edge, and false for inter community edge
-    return dis(gen) < communityBoundaryThreshold;
+    return boundaryDistribution(gen) < communityBoundaryThreshold;
 }
 
-Graph Sbm::generateSbm() {
-    // Create a graph instance
-    Graph graph(numberNodes);
+namespace {
+    // Pairs skipped before the next sampled one, geometric with success probability edgeProbability
+    long long geometricSkip(PhiloxStream& stream, double logComplement) {
+        double skip = floor(log1p(-stream.uniform()) / logComplement);
+        return (skip < 1e18) ? static_cast<long long>(skip) : static_cast<long long>(1e18);
+    }
 
-    uniform_int_distribution<int> dist(0, numberNodes - 1);
+    // First candidate position of row offset1 in the strict upper triangle of a block with size nodes
+    long long triangleRowStart(long long offset1, long long size) {
+        return offset1 * (2 * size - offset1 - 1) / 2;
+    }
+}
 
-    unordered_set<int> usedNumbers;
+vector<pair<int, int>> Sbm::generateAllEdges(int threadCount) {
+    if (!propensities.empty()) {
+        throw runtime_error("Sbm: Full instances are only available without propensities.");
+    }
 
-    int blockSize = numberNodes / numberCommunities;
+    vector<vector<pair<int, int>>> chunkEdges(samplingChunks.size());
+    atomic<size_t> nextChunk(0);
+    auto sampleChunks = [&]() {
+        for (size_t i = nextChunk++; i < samplingChunks.size(); i = nextChunk++) {
+            generateChunkEdges(i, chunkEdges[i]);
+        }
+    };
 
-    for (int i = 0; i < numberCommunities; ++i) {
-        for (int j = 0; j < blockSize; ++j) {
-            int num;
-            do {
-                num = dist(gen);
-            } while (usedNumbers.find(num) != usedNumbers.end());
+    if (threadCount <= 0) {
+        threadCount = max(1u, thread::hardware_concurrency());
+    }
+    threadCount = min<size_t>(threadCount, max<size_t>(1, samplingChunks.size()));
+    if (threadCount == 1) {
+        sampleChunks();
+    } else {
+        vector<thread> workers;
+        for (int i = 0; i < threadCount; ++i) {
+            workers.emplace_back(sampleChunks);
+        }
+        for (auto& worker: workers) {
+            worker.join();
+        }
+    }
 
-            // Update usedNumbers
-            usedNumbers.insert(num);
+    // Concatenate in chunk order
+    size_t edgeCount = 0;
+    for (const auto& edges: chunkEdges) {
+        edgeCount += edges.size();
+    }
+    vector<pair<int, int>> edges;
+    edges.reserve(edgeCount);
+    for (auto& sampled: chunkEdges) {
+        edges.insert(edges.end(), sampled.begin(), sampled.end());
+        vector<pair<int, int>>().swap(sampled);
+    }
+    return edges;
+}
+
+void Sbm::generateChunkEdges(size_t chunkIndex, vector<pair<int, int>>& edges) const {
+    if (!propensities.empty()) {
+        throw runtime_error("Sbm: Full instances are only available without propensities.");
+    }
+    PhiloxStream stream(seed, chunkIndex);
+    sampleChunk(samplingChunks.at(chunkIndex), stream, edges);
+}
+
+// Walks the candidate pairs [chunk.begin, chunk.end) of a block pair in order, jumping over the geometrically
+// distributed number of pairs that are not sampled before each sampled one. Skips are memoryless, so sampling chunks
+// separately gives the same distribution as one walk. Within a block only pairs offset1 < offset2 are candidates.
+void Sbm::sampleChunk(const SamplingChunk& chunk, PhiloxStream& stream, vector<pair<int, int>>& edges) const {
+    double edgeProbability = (chunk.firstCommunity == chunk.secondCommunity) ? intraCommunityEdgeProbability : interCommunityEdgeProbability;
+    if (edgeProbability <= 0.0) {
+        return;
+    }
+    // Every candidate is sampled with probability 1, log1p(-1) would be -inf
+    double logComplement = (edgeProbability < 1.0) ? log1p(-edgeProbability) : -numeric_limits<double>::infinity();
+    const vector<int>& firstBlock = communityTracker[chunk.firstCommunity];
+    const vector<int>& secondBlock = communityTracker[chunk.secondCommunity];
+    long long firstSize = firstBlock.size();
+    long long secondSize = secondBlock.size();
+    edges.reserve((chunk.end - chunk.begin) * edgeProbability * 1.1);
+
+    long long position = chunk.begin + geometricSkip(stream, logComplement);
+    if (chunk.firstCommunity != chunk.secondCommunity) {
+        for (; position < chunk.end; position += 1 + geometricSkip(stream, logComplement)) {
+            edges.emplace_back(firstBlock[position / secondSize], secondBlock[position % secondSize]);
+        }
+        return;
+    }
+
+    // Locate the row of the first position, then walk rows: row offset1 holds (offset1, offset1 + 1 .. size - 1)
+    long long low = 0;
+    long long high = firstSize - 2;
+    while (low < high) {
+        long long middle = (low + high + 1) / 2;
+        if (triangleRowStart(middle, firstSize) <= chunk.begin) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    long long offset1 = low;
+    long long rowStart = triangleRowStart(offset1, firstSize);
+    while (position < chunk.end) {
+        long long rowLength = firstSize - offset1 - 1;
+        if (position - rowStart >= rowLength) {
+            rowStart += rowLength;
+            offset1++;
+            continue;
+        }
+        edges.emplace_back(firstBlock[offset1], firstBlock[offset1 + 1 + (position - rowStart)]);
+        position += 1 + geometricSkip(stream, logComplement);
+    }
+}
 
-            // Assign labels to vertices
-            Node* node = graph.getNode(num);
-            node->label = i;
-            node->offset = j;
+Graph Sbm::generateSbm() {
+    // Blocks take consecutive runs of one random permutation
+    vector<int> permutation(numberNodes);
+    iota(permutation.begin(), permutation.end(), 0);
+    shuffle(permutation.begin(), permutation.end(), gen);
+
+    // Nodes left over by uneven division keep their id as label, same as in Graph(numberNodes)
+    vector<int> labels(numberNodes);
+    vector<int> offsets(numberNodes, -1);
+    iota(labels.begin(), labels.end(), 0);
+    int position = 0;
+    for (int i = 0; i < numberCommunities; ++i) {
+        for (int j = 0; j < blockSizes[i]; ++j) {
+            int num = permutation[position++];
+            labels[num] = i;
+            offsets[num] = j;
 
             // Fill tracker matrix
             communityTracker[i][j] = num;
         }
     }
 
+    // Nodes are created with their block label directly, so the community index is built once
+    Graph graph(0);
+    graph.nodes.reserve(numberNodes);
+    graph.id_to_index_mapping.reserve(numberNodes);
+    for (int num = 0; num < numberNodes; ++num) {
+        graph.addNode(num, labels[num]);
+        graph.nodes.back()->offset = offsets[num];
+    }
+
     return graph;
 }
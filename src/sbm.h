@@ -4,25 +4,62 @@
 #include <iostream>
 #include <vector>
 #include <random>
+#include <cstdint>
 
 #include "graph.h"
+#include "philox.h"
+#include "alias_table.h"
 
 using namespace std;
 
+// Candidate node pairs of one block pair sampled by one task of generateAllEdges
+struct SamplingChunk {
+    int firstCommunity;
+    int secondCommunity;
+    long long begin;
+    long long end;
+};
+
 class Sbm {
     private:
         int numberNodes;
+        uint64_t seed;
         double communityBoundaryThreshold;
+        vector<int> blockSizes;
         vector<vector<int>> communityTracker;
+        // Per node propensity, empty for the plain SBM where all nodes weigh the same
+        vector<double> propensities;
         mt19937 gen;
+        uniform_real_distribution<double> boundaryDistribution;
+        // Block of an intra community edge, and block pair of an inter community edge
+        AliasTable intraCommunityTable;
+        AliasTable interCommunityTable;
+        vector<pair<int, int>> interCommunityPairs;
+        // Offsets within each block by propensity, degree corrected mode only
+        vector<AliasTable> memberTables;
+        // Chunks of candidate pairs for full instances, chunk i draws from Philox stream i
+        vector<SamplingChunk> samplingChunks;
+
+        Sbm(int numberNodes, const vector<int>& blockSizes, double intraCommunityEdgeProbability, double interCommunityEdgeProbability, uint64_t seed, const vector<double>& propensities);
 
         Graph generateSbm();
+        void buildEdgeTables();
         bool isIntraCommunityEdge();
+        int generateOffset(int community);
         pair<int, int> generateIntraCommunityEdge();
         pair<int, int> generateInterCommunityEdge();
+        void sampleChunk(const SamplingChunk& chunk, PhiloxStream& stream, vector<pair<int, int>>& edges) const;
 
     public:
-        Sbm(int numberNodes, int numberCommunities, double intraCommunityEdgeProbability, double interCommunityEdgeProbability);
+        // Candidate pairs per sampling chunk, fixed so chunk streams do not depend on the thread count
+        static const long long chunkCandidates = 1LL << 24;
+
+        // Equal blocks of numberNodes / numberCommunities nodes, nodes left over keep their id as label and get no
+        // edges. The seed drives block assignment and all edge generation, so equal seeds give equal instances.
+        Sbm(int numberNodes, int numberCommunities, double intraCommunityEdgeProbability, double interCommunityEdgeProbability, uint64_t seed = random_device{}());
+        // One block per entry of blockSizes. With propensities (one per node id), the degree corrected SBM: edge
+        // (u, v) is drawn with weight propensity[u] * propensity[v] times the probability of their block pair.
+        Sbm(const vector<int>& blockSizes, double intraCommunityEdgeProbability, double interCommunityEdgeProbability, uint64_t seed = random_device{}(), const vector<double>& propensities = {});
         ~Sbm();
 
         // Move constructor and assignment operator
@@ -38,7 +75,26 @@ class Sbm {
         double intraCommunityEdgeProbability;
         double interCommunityEdgeProbability;
 
+        uint64_t getSeed() const { return seed; }
+        const vector<int>& getBlockSizes() const { return blockSizes; }
+        bool isDegreeCorrected() const { return !propensities.empty(); }
+        // Heavy tailed propensities for the degree corrected mode, Pareto distributed with the given exponent and
+        // scaled to mean 1
+        static vector<double> powerLawPropensities(int numberNodes, double exponent, uint64_t seed);
+        // numberCommunities block sizes of at least one node summing to numberNodes, cut at uniformly random points
+        static vector<int> randomBlockSizes(int numberNodes, int numberCommunities, uint64_t seed);
+
+        // Draws one edge in O(1)
         pair<int, int> generateEdge();
+        // Full G(n, P) instance: every node pair becomes an edge independently with the probability of its block
+        // pair. Geometric skips jump straight to the next sampled pair, so this runs in O(n + m). Block pairs are
+        // cut into fixed chunks, each drawing from its own Philox stream keyed by the seed, and chunks are spread over
+        // threadCount threads (0 for all hardware threads). The result is the same for any thread count. Not
+        // available in degree corrected mode, where pair probabilities differ within a block pair.
+        vector<pair<int, int>> generateAllEdges(int threadCount = 0);
+        // The same instance one chunk at a time, for consumers that stream it instead of holding it
+        size_t numberSamplingChunks() const { return samplingChunks.size(); }
+        void generateChunkEdges(size_t chunkIndex, vector<pair<int, int>>& edges) const;
 };
 
 #endif // SBM_H
@@ -0,0 +1,380 @@
+#include "sharded_graph.h"
+
+#include <climits>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <exception>
+#include <filesystem>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace {
+    // Ghost state sent from the owner shard
+    struct GhostRecord {
+        int id;
+        int label;
+        long long degree;
+    };
+
+    // Threads of this process, 0 where /proc is not available
+    size_t countThreads() {
+        error_code error;
+        filesystem::directory_iterator tasks("/proc/self/task", error);
+        if (error) {
+            return 0;
+        }
+        return distance(tasks, filesystem::directory_iterator());
+    }
+
+    void writeFully(int descriptor, const char* data, size_t length) {
+        while (length > 0) {
+            ssize_t written = write(descriptor, data, length);
+            if (written <= 0) {
+                throw runtime_error("Failed writing to shard socket: " + string(strerror(errno)));
+            }
+            data += written;
+            length -= written;
+        }
+    }
+
+    void readFully(int descriptor, char* data, size_t length) {
+        while (length > 0) {
+            ssize_t received = read(descriptor, data, length);
+            if (received <= 0) {
+                throw runtime_error("Shard socket closed before the payload was complete");
+            }
+            data += received;
+            length -= received;
+        }
+    }
+}
+
+Shard::Shard(int shardId): shardId(shardId), graph(0) {}
+
+bool Shard::isGhost(int nodeId) const {
+    return ghostIds.find(nodeId) != ghostIds.end();
+}
+
+long long Shard::getOwnedDegree() const {
+    long long ownedDegree = 0;
+    for (const auto& node: graph.nodes) {
+        if (!isGhost(node->id)) {
+            ownedDegree += node->degree;
+        }
+    }
+    return ownedDegree;
+}
+
+ShardTransport::~ShardTransport() {
+    // Nothing to clean
+}
+
+InProcessTransport::InProcessTransport(int numberShards):
+    numberShards(numberShards), mailboxes(numberShards * numberShards) {}
+
+void InProcessTransport::send(int fromShard, int toShard, const vector<char>& payload) {
+    {
+        lock_guard<mutex> lock(mailboxMutex);
+        mailboxes[toShard * numberShards + fromShard].push_back(payload);
+    }
+    mailboxReady.notify_all();
+}
+
+vector<char> InProcessTransport::receive(int toShard, int fromShard) {
+    unique_lock<mutex> lock(mailboxMutex);
+    deque<vector<char>>& mailbox = mailboxes[toShard * numberShards + fromShard];
+    mailboxReady.wait(lock, [&mailbox]() { return !mailbox.empty(); });
+    vector<char> payload = move(mailbox.front());
+    mailbox.pop_front();
+    return payload;
+}
+
+SocketTransport::SocketTransport(int numberShards):
+    numberShards(numberShards), descriptors(numberShards * numberShards, -1) {
+    for (int first = 0; first < numberShards; ++first) {
+        for (int second = first + 1; second < numberShards; ++second) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == -1) {
+                throw runtime_error("Unable to create shard socket pair: " + string(strerror(errno)));
+            }
+            descriptors[first * numberShards + second] = pair[0];
+            descriptors[second * numberShards + first] = pair[1];
+        }
+    }
+}
+
+SocketTransport::~SocketTransport() {
+    closeAll();
+}
+
+void SocketTransport::retainShard(int ownShard) {
+    for (size_t i = 0; i < descriptors.size(); ++i) {
+        if (int(i) / numberShards != ownShard && descriptors[i] != -1) {
+            close(descriptors[i]);
+            descriptors[i] = -1;
+        }
+    }
+}
+
+void SocketTransport::closeAll() {
+    for (int& descriptor: descriptors) {
+        if (descriptor != -1) {
+            close(descriptor);
+            descriptor = -1;
+        }
+    }
+}
+
+// Payloads are framed with their length
+void SocketTransport::send(int fromShard, int toShard, const vector<char>& payload) {
+    int descriptor = descriptors[fromShard * numberShards + toShard];
+    uint64_t length = payload.size();
+    writeFully(descriptor, reinterpret_cast<const char*>(&length), sizeof(length));
+    writeFully(descriptor, payload.data(), payload.size());
+}
+
+vector<char> SocketTransport::receive(int toShard, int fromShard) {
+    int descriptor = descriptors[toShard * numberShards + fromShard];
+    uint64_t length = 0;
+    readFully(descriptor, reinterpret_cast<char*>(&length), sizeof(length));
+    vector<char> payload(length);
+    readFully(descriptor, payload.data(), length);
+    return payload;
+}
+
+ShardedGraph::ShardedGraph(const Graph& graph, int numberShards, ShardPartition partition): partition(partition) {
+    if (numberShards < 1) {
+        throw invalid_argument("ShardedGraph: Expected at least one shard.");
+    }
+    shards.reserve(numberShards);
+    for (int i = 0; i < numberShards; ++i) {
+        shards.emplace_back(i);
+    }
+
+    if (partition == ShardPartition::Range) {
+        // Split sorted ids into equally sized ranges, ids added later fall into the range below them
+        vector<int> ids;
+        ids.reserve(graph.nodes.size());
+        for (const auto& node: graph.nodes) {
+            ids.push_back(node->id);
+        }
+        sort(ids.begin(), ids.end());
+        rangeStarts.push_back(INT_MIN);
+        for (int i = 1; i < numberShards; ++i) {
+            rangeStarts.push_back(ids.empty() ? INT_MAX : ids[i * ids.size() / numberShards]);
+        }
+    }
+
+    for (const auto& node: graph.nodes) {
+        addNode(node->id, node->label);
+        shards[getOwner(node->id)].graph.getNode(node->id)->offset = node->offset;
+    }
+    for (const auto& node: graph.nodes) {
+        for (const auto& edge: node->edgeList) {
+            addDirectedEdge(node->id, edge.first->id, edge.second);
+        }
+    }
+
+    // The source graph is at hand, so seed ghosts without an exchange
+    for (auto& shard: shards) {
+        for (int ghostId: shard.ghostIds) {
+            const Node* original = graph.getNode(ghostId);
+            Node* ghost = shard.graph.getNode(ghostId);
+            shard.graph.setLabel(ghost, original->label);
+            ghost->degree = original->degree;
+        }
+    }
+}
+
+ShardedGraph::~ShardedGraph() {
+    // Nothing to clean
+}
+
+int ShardedGraph::numberShards() const {
+    return shards.size();
+}
+
+int ShardedGraph::getOwner(int nodeId) const {
+    if (partition == ShardPartition::Range) {
+        return upper_bound(rangeStarts.begin(), rangeStarts.end(), nodeId) - rangeStarts.begin() - 1;
+    }
+    // Fibonacci hashing spreads consecutive ids across shards
+    uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(nodeId)) * 0x9E3779B97F4A7C15ULL;
+    return (hash >> 32) % shards.size();
+}
+
+// Total edges includes weight as well
+long long ShardedGraph::getTotalEdges() const {
+    long long directedEdgeWeight = 0;
+    for (const auto& shard: shards) {
+        directedEdgeWeight += shard.getOwnedDegree();
+    }
+    return directedEdgeWeight / 2;
+}
+
+void ShardedGraph::addNode(int nodeId, int nodeLabel) {
+    shards[getOwner(nodeId)].graph.addNode(nodeId, nodeLabel);
+}
+
+Node* ShardedGraph::ensureNode(Shard& shard, int nodeId) {
+    auto it = shard.graph.id_to_index_mapping.find(nodeId);
+    if (it != shard.graph.id_to_index_mapping.end()) {
+        return shard.graph.nodes[it->second].get();
+    }
+
+    // Register a ghost with its owner so the owner knows where to send updates
+    int owner = getOwner(nodeId);
+    if (!shards[owner].graph.id_to_index_mapping.count(nodeId)) {
+        throw out_of_range("Node with id " + to_string(nodeId) + " not found in any shard.");
+    }
+    shard.graph.addNode(nodeId, -1);
+    shard.ghostIds.insert(nodeId);
+    shards[owner].subscribers[shard.shardId].push_back(nodeId);
+    return shard.graph.getNode(nodeId);
+}
+
+void ShardedGraph::addDirectedEdge(int srcNodeId, int destNodeId, int edgeWeight) {
+    Shard& shard = shards[getOwner(srcNodeId)];
+    Node* srcNode = shard.graph.getNode(srcNodeId);
+    Node* destNode = ensureNode(shard, destNodeId);
+    shard.graph.addEdge(srcNode, destNode, edgeWeight);
+}
+
+// Each direction is stored on the owner of its source
+void ShardedGraph::addUndirectedEdge(int srcNodeId, int destNodeId, int edgeWeight) {
+    addDirectedEdge(srcNodeId, destNodeId, edgeWeight);
+    addDirectedEdge(destNodeId, srcNodeId, edgeWeight);
+}
+
+void ShardedGraph::removeUndirectedEdge(int srcNodeId, int destNodeId) {
+    shards[getOwner(srcNodeId)].graph.removeEdge(srcNodeId, destNodeId);
+    if (srcNodeId != destNodeId) {
+        shards[getOwner(destNodeId)].graph.removeEdge(destNodeId, srcNodeId);
+    }
+}
+
+Graph ShardedGraph::gather() const {
+    Graph graph(0);
+    for (const auto& shard: shards) {
+        for (const auto& node: shard.graph.nodes) {
+            if (!shard.isGhost(node->id)) {
+                graph.addNode(node->id, node->label);
+                graph.getNode(node->id)->offset = node->offset;
+            }
+        }
+    }
+
+    for (const auto& shard: shards) {
+        for (const auto& node: shard.graph.nodes) {
+            if (shard.isGhost(node->id)) {
+                continue;
+            }
+            Node* srcNode = graph.getNode(node->id);
+            for (const auto& edge: node->edgeList) {
+                graph.addEdge(srcNode, graph.getNode(edge.first->id), edge.second);
+            }
+        }
+    }
+    return graph;
+}
+
+void exchangeGhosts(Shard& shard, int numberShards, ShardTransport& transport) {
+    auto sendUpdates = [&](int peer) {
+        vector<GhostRecord> records;
+        auto it = shard.subscribers.find(peer);
+        if (it != shard.subscribers.end()) {
+            records.reserve(it->second.size());
+            for (int nodeId: it->second) {
+                const Node* node = shard.graph.getNode(nodeId);
+                records.push_back({node->id, node->label, node->degree});
+            }
+        }
+        vector<char> payload(records.size() * sizeof(GhostRecord));
+        memcpy(payload.data(), records.data(), payload.size());
+        transport.send(shard.shardId, peer, payload);
+    };
+
+    auto receiveUpdates = [&](int peer) {
+        vector<char> payload = transport.receive(shard.shardId, peer);
+        vector<GhostRecord> records(payload.size() / sizeof(GhostRecord));
+        memcpy(records.data(), payload.data(), records.size() * sizeof(GhostRecord));
+        for (const GhostRecord& record: records) {
+            Node* ghost = shard.graph.getNode(record.id);
+            shard.graph.setLabel(ghost, record.label);
+            ghost->degree = record.degree;
+        }
+    };
+
+    for (int peer = 0; peer < numberShards; ++peer) {
+        if (peer < shard.shardId) {
+            receiveUpdates(peer);
+            sendUpdates(peer);
+        } else if (peer > shard.shardId) {
+            sendUpdates(peer);
+            receiveUpdates(peer);
+        }
+    }
+}
+
+void runShardThreads(ShardedGraph& sharded, const function<void(Shard&, ShardTransport&)>& worker) {
+    InProcessTransport transport(sharded.numberShards());
+    vector<exception_ptr> errors(sharded.numberShards());
+    vector<thread> workers;
+    for (int i = 0; i < sharded.numberShards(); ++i) {
+        workers.emplace_back([&, i]() {
+            try {
+                worker(sharded.shards[i], transport);
+            } catch (...) {
+                errors[i] = current_exception();
+            }
+        });
+    }
+    for (auto& thread: workers) {
+        thread.join();
+    }
+    for (const auto& error: errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+}
+
+int runShardProcesses(ShardedGraph& sharded, const function<int(Shard&, ShardTransport&)>& worker) {
+    // Children allocate and run graph code after fork, which is only safe when no other thread could hold a lock
+    if (countThreads() > 1) {
+        throw runtime_error("Shard processes have to be forked before any other thread is started");
+    }
+    SocketTransport transport(sharded.numberShards());
+    vector<pid_t> children;
+    for (int i = 0; i < sharded.numberShards(); ++i) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            throw runtime_error("Unable to fork shard process: " + string(strerror(errno)));
+        }
+        if (pid == 0) {
+            transport.retainShard(i);
+            int status = 1;
+            try {
+                status = worker(sharded.shards[i], transport);
+            } catch (...) {
+                status = 1;
+            }
+            _exit(status);
+        }
+        children.push_back(pid);
+    }
+    // Peers of a failed worker only see end of file once the parent's copies are gone too
+    transport.closeAll();
+
+    int failures = 0;
+    for (pid_t child: children) {
+        int status = 0;
+        if (waitpid(child, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failures++;
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,114 @@
+#ifndef SHARDED_GRAPH_H
+#define SHARDED_GRAPH_H
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <stdexcept>
+
+#include "graph.h"
+
+using namespace std;
+
+
+enum class ShardPartition {
+    Hash,   // Owner by hashed node id
+    Range   // Contiguous id ranges with equal node counts
+};
+
+// One partition of a ShardedGraph. The shard graph holds owned nodes with their full edge lists plus ghost copies
+// of neighbors owned elsewhere; ghosts have no edges and their label and degree are refreshed by exchangeGhosts.
+class Shard {
+    public:
+        int shardId;
+        Graph graph;
+        unordered_set<int> ghostIds;
+        // Peer shard -> owned node ids that peer holds as ghosts
+        unordered_map<int, vector<int>> subscribers;
+
+        explicit Shard(int shardId);
+
+        bool isGhost(int nodeId) const;
+        // Sum of owned degrees, half of it is this shard's share of the total edge weight
+        long long getOwnedDegree() const;
+};
+
+// Moves byte payloads between shards. Workers call send and receive for their own shard only.
+class ShardTransport {
+    public:
+        virtual ~ShardTransport();
+        virtual void send(int fromShard, int toShard, const vector<char>& payload) = 0;
+        virtual vector<char> receive(int toShard, int fromShard) = 0;
+};
+
+// Mailboxes for shards running as threads of one process
+class InProcessTransport: public ShardTransport {
+    public:
+        explicit InProcessTransport(int numberShards);
+        void send(int fromShard, int toShard, const vector<char>& payload) override;
+        vector<char> receive(int toShard, int fromShard) override;
+
+    private:
+        int numberShards;
+        mutex mailboxMutex;
+        condition_variable mailboxReady;
+        vector<deque<vector<char>>> mailboxes; // indexed by toShard * numberShards + fromShard
+};
+
+// Unix socket pair between every two shards, created before forking so each process inherits its ends
+class SocketTransport: public ShardTransport {
+    public:
+        explicit SocketTransport(int numberShards);
+        ~SocketTransport();
+        void send(int fromShard, int toShard, const vector<char>& payload) override;
+        vector<char> receive(int toShard, int fromShard) override;
+        // Closes every socket end not owned by ownShard. Forked workers keep only their own ends, so a worker that
+        // exits early leaves its peers with end of file instead of blocking them.
+        void retainShard(int ownShard);
+        void closeAll();
+
+    private:
+        int numberShards;
+        vector<int> descriptors; // indexed by ownShard * numberShards + peerShard
+};
+
+class ShardedGraph {
+    private:
+        ShardPartition partition;
+        vector<int> rangeStarts; // first id of every shard for range partitioning
+
+        Node* ensureNode(Shard& shard, int nodeId);
+        void addDirectedEdge(int srcNodeId, int destNodeId, int edgeWeight);
+
+    public:
+        vector<Shard> shards;
+
+        ShardedGraph(const Graph& graph, int numberShards, ShardPartition partition = ShardPartition::Hash);
+        ~ShardedGraph();
+
+        int numberShards() const;
+        int getOwner(int nodeId) const;
+        long long getTotalEdges() const;
+        void addNode(int nodeId, int nodeLabel);
+        void addUndirectedEdge(int srcNodeId, int destNodeId, int edgeWeight = 1);
+        void removeUndirectedEdge(int srcNodeId, int destNodeId);
+        // Reassembles the owned nodes of all shards into one graph
+        Graph gather() const;
+};
+
+// Sends the label and degree of every subscribed owned node to its peers and applies the updates received for
+// ghosts. Peers are visited pairwise in id order, so blocking transports cannot deadlock.
+void exchangeGhosts(Shard& shard, int numberShards, ShardTransport& transport);
+
+// Runs worker once per shard, either on threads sharing an InProcessTransport or in forked processes sharing a
+// SocketTransport. Process workers return an exit status, the number of failed workers is returned. Changes made
+// by process workers stay in the child. Children run the worker right after fork, so runShardProcesses has to be called
+// while the process is still single threaded and throws otherwise.
+void runShardThreads(ShardedGraph& sharded, const function<void(Shard&, ShardTransport&)>& worker);
+int runShardProcesses(ShardedGraph& sharded, const function<int(Shard&, ShardTransport&)>& worker);
+
+#endif // SHARDED_GRAPH_H
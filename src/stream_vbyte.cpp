@@ -0,0 +1,140 @@
+#include "stream_vbyte.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STREAM_VBYTE_X86
+#endif
+
+
+namespace {
+    int encodedLength(uint32_t value) {
+        if (value < (1u << 8)) {
+            return 1;
+        } else if (value < (1u << 16)) {
+            return 2;
+        } else if (value < (1u << 24)) {
+            return 3;
+        }
+        return 4;
+    }
+
+    // Decodes one group of up to four values, returns bytes consumed
+    size_t decodeGroupScalar(uint8_t control, const uint8_t* data, size_t count, bool delta, uint32_t& previous, uint32_t* values) {
+        size_t consumed = 0;
+        for (size_t i = 0; i < count; ++i) {
+            int length = ((control >> (2 * i)) & 3) + 1;
+            uint32_t value = 0;
+            for (int byte = 0; byte < length; ++byte) {
+                value |= static_cast<uint32_t>(data[consumed + byte]) << (8 * byte);
+            }
+            consumed += length;
+            if (delta) {
+                value += previous;
+                previous = value;
+            }
+            values[i] = value;
+        }
+        return consumed;
+    }
+
+#ifdef STREAM_VBYTE_X86
+    // Shuffle masks spreading the value bytes of a control byte into four 32 bit lanes, and the bytes consumed
+    struct ShuffleTables {
+        alignas(16) uint8_t masks[256][16];
+        uint8_t lengths[256];
+
+        ShuffleTables() {
+            for (int control = 0; control < 256; ++control) {
+                int source = 0;
+                for (int lane = 0; lane < 4; ++lane) {
+                    int length = ((control >> (2 * lane)) & 3) + 1;
+                    for (int byte = 0; byte < 4; ++byte) {
+                        masks[control][4 * lane + byte] = (byte < length) ? source + byte : 0x80;
+                    }
+                    source += length;
+                }
+                lengths[control] = source;
+            }
+        }
+    };
+
+    const ShuffleTables& getShuffleTables() {
+        static const ShuffleTables tables;
+        return tables;
+    }
+
+    __attribute__((target("ssse3")))
+    size_t decodeSsse3(const uint8_t* controls, const uint8_t* data, size_t count, bool delta, uint32_t& previous, uint32_t* values) {
+        const ShuffleTables& shuffleTables = getShuffleTables();
+        const uint8_t* start = data;
+        size_t groups = count / 4;
+        __m128i base = _mm_set1_epi32(previous);
+        for (size_t group = 0; group < groups; ++group) {
+            uint8_t control = controls[group];
+            __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffleTables.masks[control]));
+            __m128i decoded = _mm_shuffle_epi8(packed, mask);
+            if (delta) {
+                // Prefix sum over the four lanes, then add the running base
+                decoded = _mm_add_epi32(decoded, _mm_slli_si128(decoded, 4));
+                decoded = _mm_add_epi32(decoded, _mm_slli_si128(decoded, 8));
+                decoded = _mm_add_epi32(decoded, base);
+                base = _mm_shuffle_epi32(decoded, 0xFF);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(values + 4 * group), decoded);
+            data += shuffleTables.lengths[control];
+        }
+        if (delta) {
+            previous = _mm_cvtsi128_si32(base);
+        }
+
+        size_t remainder = count - 4 * groups;
+        if (remainder > 0) {
+            data += decodeGroupScalar(controls[groups], data, remainder, delta, previous, values + 4 * groups);
+        }
+        return data - start;
+    }
+
+    bool hasSsse3() {
+        static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+        return supported;
+    }
+#endif
+}
+
+size_t streamVByteEncode(const uint32_t* values, size_t count, bool delta, uint32_t previous, vector<uint8_t>& controls, vector<uint8_t>& data) {
+    size_t start = data.size();
+    for (size_t group = 0; group < count; group += 4) {
+        uint8_t control = 0;
+        for (size_t i = group; i < min(group + 4, count); ++i) {
+            uint32_t value = delta ? values[i] - previous : values[i];
+            previous = values[i];
+            int length = encodedLength(value);
+            control |= (length - 1) << (2 * (i - group));
+            for (int byte = 0; byte < length; ++byte) {
+                data.push_back((value >> (8 * byte)) & 0xFF);
+            }
+        }
+        controls.push_back(control);
+    }
+    return data.size() - start;
+}
+
+size_t streamVByteDecodeScalar(const uint8_t* controls, const uint8_t* data, size_t count, bool delta, uint32_t& previous, uint32_t* values) {
+    size_t consumed = 0;
+    for (size_t group = 0; group < count; group += 4) {
+        consumed += decodeGroupScalar(controls[group / 4], data + consumed, min<size_t>(4, count - group), delta, previous, values + group);
+    }
+    return consumed;
+}
+
+size_t streamVByteDecode(const uint8_t* controls, const uint8_t* data, size_t count, bool delta, uint32_t& previous, uint32_t* values) {
+#ifdef STREAM_VBYTE_X86
+    if (hasSsse3()) {
+        return decodeSsse3(controls, data, count, delta, previous, values);
+    }
+#endif
+    return streamVByteDecodeScalar(controls, data, count, delta, previous, values);
+}
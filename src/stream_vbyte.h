@@ -0,0 +1,26 @@
+#ifndef STREAM_VBYTE_H
+#define STREAM_VBYTE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+
+// Stream VByte integer codec. Every group of four values shares a control byte holding their byte lengths (2 bits
+// each), value bytes follow little endian in a separate data stream. With delta set, values are encoded as the
+// difference to their predecessor, so they must be non-decreasing.
+
+// Decoders may read this many bytes past the last value, data buffers must be padded accordingly
+const size_t streamVBytePadding = 16;
+
+// Appends count values to controls and data, returns bytes written to data
+size_t streamVByteEncode(const uint32_t* values, size_t count, bool delta, uint32_t previous, vector<uint8_t>& controls, vector<uint8_t>& data);
+
+// Decodes count values, returns bytes consumed from data. previous carries the running delta base across calls.
+// Uses SSSE3 shuffles when the CPU supports them.
+size_t streamVByteDecode(const uint8_t* controls, const uint8_t* data, size_t count, bool delta, uint32_t& previous, uint32_t* values);
+size_t streamVByteDecodeScalar(const uint8_t* controls, const uint8_t* data, size_t count, bool delta, uint32_t& previous, uint32_t* values);
+
+#endif // STREAM_VBYTE_H
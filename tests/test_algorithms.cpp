@@ -352,3 +352,36 @@ TEST_F(InitConf, MaximalMatchingAccuracyTest) {
         outfile << left << setw(6) << index++ << setw(20) << rank.first << setprecision(4) << rank.second << endl;
     }
 }
+
+TEST(BeliefPropagationTest, MessagesFollowEdgeChurn) {
+    Sbm sbm(300, 3, 0.1, 0.005, 21);
+    WorkloadConfig config;
+    config.numberAdditions = 3000;
+    config.windowSize = 1200;
+    config.deleteRate = 0.3;
+    config.seed = 22;
+    WorkloadEdgeStream workload(sbm, config);
+    BeliefPropagation bp(sbm.sbm_graph, 3, 2, 0.1, 0.005, workload);
+
+    EXPECT_EQ(bp.bp_graph.getTotalEdges(), workload.numberLiveEdges());
+    EXPECT_TRUE(bp.edgeIdsConsistent());
+    for (const auto& node: bp.bp_graph.nodes) {
+        EXPECT_GE(node->label, 0);
+        EXPECT_LT(node->label, 3);
+    }
+
+    // Repeated additions coalesce and removals of missing edges are ignored
+    vector<pair<int, int>> addedEdges{{0, 1}, {1, 2}, {0, 1}, {2, 3}};
+    vector<pair<int, int>> removedEdges{{0, 1}, {4, 5}, {1, 2}};
+    BeliefPropagation small(sbm.sbm_graph, 3, 2, 0.1, 0.005, addedEdges, removedEdges);
+    EXPECT_EQ(small.bp_graph.getTotalEdges(), 1);
+    EXPECT_TRUE(small.edgeIdsConsistent());
+}
+
+TEST(SequenceGeneratorTest, ChurnWorkloadsAreOnlyStreamed) {
+    // Edge lists can't keep additions and removals interleaved
+    EXPECT_THROW(generateSequence("churn.json"), runtime_error);
+    generated_sequence gs = generateSequence("churn.json", false);
+    EXPECT_FALSE(gs.workload.isStatic());
+    EXPECT_TRUE(gs.addedEdges.empty());
+}
@@ -0,0 +1,1001 @@
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <future>
+#include "src/graph.h"
+#include "src/csr_graph.h"
+#include "src/edge_events.h"
+#include "src/sharded_graph.h"
+#include "src/concurrent_graph.h"
+#include "src/compressed_csr_graph.h"
+#include "src/sbm.h"
+#include "src/edge_stream.h"
+#include "src/dynamic_workload.h"
+#include "src/evolving_sbm.h"
+#include "src/message_kernel.h"
+#include "utils/quality_measures.h"
+
+// Small two-community graph used across graph structure tests
+static Graph createTwoCommunityGraph() {
+    Graph graph(6);
+    for (int i = 0; i < 6; ++i) {
+        graph.setLabel(i, i / 3);
+    }
+    graph.addUndirectedEdge(0, 1);
+    graph.addUndirectedEdge(1, 2);
+    graph.addUndirectedEdge(0, 2);
+    graph.addUndirectedEdge(3, 4);
+    graph.addUndirectedEdge(4, 5);
+    graph.addUndirectedEdge(3, 5);
+    graph.addUndirectedEdge(2, 3);
+    return graph;
+}
+
+TEST(GraphTest, RemoveNodeKeepsMappingConsistent) {
+    Graph graph = createTwoCommunityGraph();
+    graph.removeNode(2);
+    graph.removeNode(0);
+    graph.addNode(6, 1);
+    graph.addUndirectedEdge(6, 5);
+
+    EXPECT_EQ(graph.nodes.size(), 5);
+    EXPECT_THROW(graph.getNode(2), out_of_range);
+    for (size_t index = 0; index < graph.nodes.size(); ++index) {
+        EXPECT_EQ(graph.id_to_index_mapping.at(graph.nodes[index]->id), index);
+    }
+    EXPECT_EQ(graph.getEdgeWeight(1, 2), 0);
+    EXPECT_EQ(graph.getEdgeWeight(3, 2), 0);
+    EXPECT_EQ(graph.getNode(6)->edgeList.size(), 1);
+    EXPECT_EQ(graph.getTotalEdges(), 4);
+}
+
+TEST(GraphTest, HubAdjacencyCoalescesAndRemoves) {
+    Graph graph(200);
+    for (int i = 1; i < 200; ++i) {
+        graph.addUndirectedEdge(0, i);
+    }
+    for (int i = 1; i < 200; i += 2) {
+        graph.addUndirectedEdge(graph.getNode(i), graph.getNode(0), 2);
+    }
+    for (int i = 1; i < 200; i += 3) {
+        graph.removeUndirectedEdge(0, i);
+    }
+
+    const Node* hub = graph.getNode(0);
+    int expectedDegree = 0;
+    for (int i = 1; i < 200; ++i) {
+        int expectedWeight = (i % 3 == 1) ? 0 : ((i % 2 == 1) ? 3 : 1);
+        EXPECT_EQ(graph.getEdgeWeight(0, i), expectedWeight);
+        EXPECT_EQ(graph.getEdgeWeight(i, 0), expectedWeight);
+        expectedDegree += expectedWeight;
+    }
+    EXPECT_EQ(hub->degree, expectedDegree);
+    EXPECT_EQ(graph.getTotalEdges(), expectedDegree);
+
+    // Copies keep the adjacency lookups intact
+    Graph copy = graph;
+    EXPECT_EQ(copy.getEdgeWeight(0, 5), 3);
+    EXPECT_EQ(copy.getEdgeWeight(0, 4), 0);
+    EXPECT_EQ(copy.getNode(0)->degree, expectedDegree);
+    EXPECT_EQ(copy.getTotalEdges(), expectedDegree);
+
+    graph.removeNode(0);
+    EXPECT_EQ(graph.getTotalEdges(), 0);
+}
+
+TEST(GraphTest, HubPromotionFollowsThresholdWithHysteresis) {
+    size_t previousThreshold = Node::getHubThreshold();
+    Node::setHubThreshold(8);
+
+    Graph graph(20);
+    for (int i = 1; i <= 8; ++i) {
+        graph.addUndirectedEdge(0, i);
+    }
+    EXPECT_FALSE(graph.getNode(0)->isHub());
+    graph.addUndirectedEdge(0, 9);
+    EXPECT_TRUE(graph.getNode(0)->isHub());
+
+    // Stays a hub until it falls to half the threshold
+    for (int i = 9; i >= 6; --i) {
+        graph.removeUndirectedEdge(0, i);
+        EXPECT_TRUE(graph.getNode(0)->isHub());
+    }
+    graph.removeUndirectedEdge(0, 5);
+    EXPECT_FALSE(graph.getNode(0)->isHub());
+    for (int i = 1; i <= 9; ++i) {
+        EXPECT_EQ(graph.getEdgeWeight(0, i), i <= 4 ? 1 : 0);
+    }
+    EXPECT_EQ(graph.getNode(0)->degree, 4);
+
+    Node::setHubThreshold(previousThreshold);
+}
+
+TEST(GraphTest, BulkIngestionMatchesIncremental) {
+    vector<pair<int, int>> edges;
+    vector<int> weights;
+    for (int i = 0; i < 300; ++i) {
+        edges.emplace_back((i * 7) % 50, (i * 13) % 50);
+        weights.push_back(1 + i % 3);
+    }
+    for (int i = 1; i < 50; ++i) {
+        edges.emplace_back(0, i);
+        weights.push_back(1);
+    }
+
+    Graph incremental(50);
+    incremental.addUndirectedEdge(1, 2, 5);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        incremental.addUndirectedEdge(edges[i].first, edges[i].second, weights[i]);
+    }
+
+    for (bool parallel: {false, true}) {
+        Graph bulk(50);
+        bulk.addUndirectedEdge(1, 2, 5);
+        bulk.addEdgesBulk(edges, weights, parallel);
+
+        EXPECT_EQ(bulk.getTotalEdges(), incremental.getTotalEdges());
+        for (int src = 0; src < 50; ++src) {
+            EXPECT_EQ(bulk.getNode(src)->degree, incremental.getNode(src)->degree);
+            EXPECT_EQ(bulk.getNode(src)->edgeList.size(), incremental.getNode(src)->edgeList.size());
+            for (int dest = 0; dest < 50; ++dest) {
+                EXPECT_EQ(bulk.getEdgeWeight(src, dest), incremental.getEdgeWeight(src, dest));
+            }
+        }
+    }
+}
+
+TEST(GraphTest, ParallelCopyMatchesSource) {
+    // Large enough for the copy to split across threads
+    const int numberNodes = 5000;
+    Graph source(numberNodes);
+    vector<pair<int, int>> edges;
+    for (int i = 0; i < 40000; ++i) {
+        edges.emplace_back((i * 7919) % numberNodes, (i * 4903 + 1) % numberNodes);
+    }
+    for (int i = 1; i < numberNodes; i += 5) {
+        edges.emplace_back(0, i);
+    }
+    source.addEdgesBulk(edges);
+    source.removeNode(17);
+    for (const auto& node: source.nodes) {
+        source.setLabel(node.get(), node->id % 7);
+    }
+
+    Graph copy(1);
+    copy = source;
+    Graph constructed = source;
+    for (const Graph* graph: {&copy, &constructed}) {
+        EXPECT_EQ(graph->getTotalEdges(), source.getTotalEdges());
+        EXPECT_EQ(graph->getCommunities(), source.getCommunities());
+        ASSERT_EQ(graph->nodes.size(), source.nodes.size());
+        for (size_t index = 0; index < source.nodes.size(); ++index) {
+            const Node* original = source.nodes[index].get();
+            const Node* node = graph->nodes[index].get();
+            EXPECT_EQ(node->id, original->id);
+            EXPECT_EQ(node->degree, original->degree);
+            EXPECT_EQ(node->isHub(), original->isHub());
+            ASSERT_EQ(node->edgeList.size(), original->edgeList.size());
+            for (size_t slot = 0; slot < node->edgeList.size(); ++slot) {
+                EXPECT_EQ(node->edgeList[slot].first, graph->getNode(original->edgeList[slot].first->id));
+                EXPECT_EQ(node->edgeList[slot].second, original->edgeList[slot].second);
+            }
+        }
+    }
+
+    // Copies are independent of their source
+    copy.removeUndirectedEdge(0, 1);
+    copy.setLabel(0, 9);
+    EXPECT_EQ(source.getEdgeWeight(0, 1), constructed.getEdgeWeight(0, 1));
+    EXPECT_EQ(source.getNode(0)->label, 0);
+    EXPECT_EQ(copy.getCommunity(9).size(), 1);
+}
+
+TEST(GraphTest, ReorderNodesPreservesGraph) {
+    for (NodeOrder order: {NodeOrder::Degree, NodeOrder::ReverseCuthillMcKee, NodeOrder::Community}) {
+        Graph original = createTwoCommunityGraph();
+        original.addUndirectedEdge(4, 4);
+        original.addUndirectedEdge(2, 5, 3);
+        Graph reordered = original;
+        reordered.reorderNodes(order);
+
+        EXPECT_EQ(reordered.nodes.size(), original.nodes.size());
+        EXPECT_EQ(reordered.getTotalEdges(), original.getTotalEdges());
+        for (size_t index = 0; index < reordered.nodes.size(); ++index) {
+            const Node* node = reordered.nodes[index].get();
+            EXPECT_EQ(reordered.id_to_index_mapping.at(node->id), index);
+            EXPECT_EQ(node->label, original.getNode(node->id)->label);
+            EXPECT_EQ(node->degree, original.getNode(node->id)->degree);
+            for (int dest = 0; dest < 6; ++dest) {
+                EXPECT_EQ(reordered.getEdgeWeight(node->id, dest), original.getEdgeWeight(node->id, dest));
+            }
+        }
+    }
+
+    Graph graph = createTwoCommunityGraph();
+    graph.reorderNodes(NodeOrder::Degree);
+    for (size_t index = 1; index < graph.nodes.size(); ++index) {
+        EXPECT_GE(graph.nodes[index - 1]->degree, graph.nodes[index]->degree);
+    }
+}
+
+TEST(CsrGraphTest, SnapshotMatchesGraph) {
+    Graph graph = createTwoCommunityGraph();
+    CsrGraph snapshot(graph);
+
+    EXPECT_EQ(snapshot.numberNodes(), 6);
+    EXPECT_EQ(snapshot.numberEdgeEntries(), 14);
+    EXPECT_EQ(snapshot.getTotalEdges(), graph.getTotalEdges());
+    for (int index = 0; index < snapshot.numberNodes(); ++index) {
+        const Node* node = graph.getNode(snapshot.getId(index));
+        EXPECT_EQ(snapshot.getLabel(index), node->label);
+        EXPECT_EQ(snapshot.neighborEnd(index) - snapshot.neighborBegin(index), node->edgeList.size());
+        for (int position = snapshot.neighborBegin(index); position < snapshot.neighborEnd(index); ++position) {
+            int neighborId = snapshot.getId(snapshot.getNeighbor(position));
+            EXPECT_EQ(snapshot.getWeight(position), graph.getEdgeWeight(node->id, neighborId));
+        }
+    }
+}
+
+TEST(CsrGraphTest, ModularityMatchesSnapshotLabels) {
+    Graph graph = createTwoCommunityGraph();
+    CsrGraph snapshot(graph);
+    double graph_modularity = modularity(graph);
+
+    EXPECT_DOUBLE_EQ(graph_modularity, modularity(snapshot));
+    EXPECT_GT(graph_modularity, 0.0);
+
+    // Labels are mutable on the snapshot without touching the graph
+    for (int index = 0; index < snapshot.numberNodes(); ++index) {
+        snapshot.setLabel(index, index);
+    }
+    EXPECT_LT(modularity(snapshot), graph_modularity);
+    EXPECT_DOUBLE_EQ(modularity(graph), graph_modularity);
+}
+
+TEST(BinaryFormatTest, GraphRoundTripsThroughMappedFile) {
+    Graph graph = createTwoCommunityGraph();
+    graph.addUndirectedEdge(graph.getNode(0), graph.getNode(5), 3);
+    string filepath = (filesystem::temp_directory_path() / "sbm_test_graph.bin").string();
+    CsrGraph(graph).writeFile(filepath);
+
+    CsrGraph mapped = CsrGraph::mapFile(filepath);
+    EXPECT_EQ(mapped.numberNodes(), 6);
+    EXPECT_EQ(mapped.getTotalEdges(), graph.getTotalEdges());
+
+    Graph loaded(mapped);
+    EXPECT_EQ(loaded.getTotalEdges(), graph.getTotalEdges());
+    EXPECT_EQ(loaded.getLabels(), graph.getLabels());
+    for (const auto& node: graph.nodes) {
+        EXPECT_EQ(loaded.getNode(node->id)->degree, node->degree);
+        for (const auto& edge: node->edgeList) {
+            EXPECT_EQ(loaded.getEdgeWeight(node->id, edge.first->id), edge.second);
+        }
+    }
+
+    // Corrupt entries fail on load instead of when the graph is rebuilt from them
+    int firstEnd = mapped.neighborEnd(0), firstDegree = mapped.getDegree(0);
+    int firstId = mapped.getId(0), secondId = mapped.getId(1), firstNeighborIndex = mapped.getNeighbor(0);
+    auto overwrite = [&filepath](size_t entry, int value) {
+        fstream file(filepath, ios::binary | ios::in | ios::out);
+        file.seekp(sizeof(BinaryGraphHeader) + entry * sizeof(int));
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    size_t firstNeighbor = 7 + 3 * 6;
+    overwrite(firstNeighbor, 6);
+    EXPECT_THROW(CsrGraph::mapFile(filepath), runtime_error);
+    overwrite(firstNeighbor, firstNeighborIndex);
+    overwrite(1, mapped.numberEdgeEntries() + 1);
+    EXPECT_THROW(CsrGraph::mapFile(filepath), runtime_error);
+    overwrite(1, firstEnd);
+    // Degree of the first node no longer matches its weights
+    size_t firstDegreeEntry = 7 + 2 * 6;
+    overwrite(firstDegreeEntry, firstDegree + 1);
+    EXPECT_THROW(CsrGraph::mapFile(filepath), runtime_error);
+    overwrite(firstDegreeEntry, firstDegree);
+    // Second node reuses the id of the first
+    overwrite(7 + 1, firstId);
+    EXPECT_THROW(CsrGraph::mapFile(filepath), runtime_error);
+    overwrite(7 + 1, secondId);
+    EXPECT_NO_THROW(CsrGraph::mapFile(filepath));
+    filesystem::remove(filepath);
+}
+
+TEST(BinaryFormatTest, EdgeEventsAppendAcrossWriters) {
+    string filepath = (filesystem::temp_directory_path() / "sbm_test_edges.bin").string();
+    filesystem::remove(filepath);
+    {
+        EdgeEventWriter writer(filepath);
+        writer.append({{0, 1}, {1, 2}}, EdgeOp::Add);
+    }
+    {
+        EdgeEventWriter writer(filepath);
+        writer.append(0, 1, EdgeOp::Remove);
+    }
+
+    MappedEdgeEvents events(filepath);
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events[2].op, EdgeOp::Remove);
+
+    vector<pair<int, int>> addedEdges, removedEdges;
+    events.split(addedEdges, removedEdges);
+    EXPECT_EQ(addedEdges, (vector<pair<int, int>>{{0, 1}, {1, 2}}));
+    EXPECT_EQ(removedEdges, (vector<pair<int, int>>{{0, 1}}));
+    filesystem::remove(filepath);
+}
+
+TEST(BinaryFormatTest, EdgeEventsAppendAfterPartialRecord) {
+    string filepath = (filesystem::temp_directory_path() / "sbm_test_partial_edges.bin").string();
+    filesystem::remove(filepath);
+    {
+        EdgeEventWriter writer(filepath);
+        writer.append(0, 1, EdgeOp::Add);
+    }
+    {
+        // Half a record, as left by a writer killed mid write
+        ofstream file(filepath, ios::binary | ios::app);
+        EdgeEvent partial{};
+        partial.src = 5;
+        file.write(reinterpret_cast<const char*>(&partial), sizeof(partial) / 2);
+    }
+    {
+        EdgeEventWriter writer(filepath);
+        writer.append(1, 2, EdgeOp::Remove);
+    }
+
+    MappedEdgeEvents events(filepath);
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_EQ(events[1].src, 1);
+    EXPECT_EQ(events[1].dest, 2);
+    EXPECT_EQ(events[1].op, EdgeOp::Remove);
+    EXPECT_EQ(filesystem::file_size(filepath), sizeof(EdgeEventHeader) + 2 * sizeof(EdgeEvent));
+    filesystem::remove(filepath);
+}
+
+TEST(GraphTest, TemplatedGraphWidensTotalsAndIds) {
+    // 8 bit labels, totals beyond the range of int
+    CompactGraph compact(3);
+    compact.setLabel(0u, 200);
+    compact.addUndirectedEdge(0u, 1u, 2000000000u);
+    compact.addUndirectedEdge(1u, 2u, 2000000000u);
+    EXPECT_EQ(compact.getTotalEdges(), 4000000000LL);
+    EXPECT_EQ(compact.getNode(1)->degree, 4000000000LL);
+    EXPECT_EQ(compact.getCommunities().at(200).size(), 1);
+    // One label per node, 8 bits don't cover 300 nodes
+    EXPECT_THROW(CompactGraph(300), invalid_argument);
+
+    // 64 bit ids
+    LargeGraph large(0);
+    uint64_t farId = (1ULL << 40) + 7;
+    large.addNode(farId, 1);
+    large.addNode(3, 1);
+    large.addEdgesBulk({{farId, 3}, {3, farId}});
+    EXPECT_EQ(large.getEdgeWeight(farId, 3), 2u);
+    large.removeNode(farId);
+    EXPECT_EQ(large.getTotalEdges(), 0);
+    EXPECT_EQ(large.nodes.size(), 1);
+}
+
+TEST(GraphTest, CommunityIndexFollowsLabelChanges) {
+    Graph graph = createTwoCommunityGraph();
+    EXPECT_EQ(graph.numberCommunities(), 2);
+    EXPECT_EQ(graph.getCommunity(0).size(), 3);
+
+    graph.setLabel(2, 1);
+    EXPECT_EQ(graph.getCommunity(0).size(), 2);
+    EXPECT_EQ(graph.getCommunities().at(1), (set<int>{2, 3, 4, 5}));
+
+    graph.removeNode(0);
+    graph.removeNode(1);
+    EXPECT_EQ(graph.numberCommunities(), 1);
+    EXPECT_TRUE(graph.getCommunity(0).empty());
+
+    // Copies and reordering index their own nodes
+    Graph copy = graph;
+    copy.reorderNodes(NodeOrder::Degree);
+    copy.setLabel(5, 7);
+    for (const auto& community: copy.getCommunityMembers()) {
+        for (const Node* member: community.second) {
+            EXPECT_EQ(member, copy.getNode(member->id));
+            EXPECT_EQ(member->label, community.first);
+        }
+    }
+    EXPECT_EQ(graph.getCommunity(1).size(), 4);
+    EXPECT_EQ(copy.getCommunity(1).size(), 3);
+
+    // A label written past setLabel leaves the index stale, later updates refuse instead of corrupting it
+    copy.getNode(5)->label = 1;
+    EXPECT_THROW(copy.setLabel(5, 2), logic_error);
+    EXPECT_THROW(copy.removeNode(5), logic_error);
+    EXPECT_EQ(copy.getNode(5)->edgeList.size(), graph.getNode(5)->edgeList.size());
+}
+
+TEST(ShardedGraphTest, ShardsReassembleIntoOriginal) {
+    Graph graph = createTwoCommunityGraph();
+    for (ShardPartition partition: {ShardPartition::Hash, ShardPartition::Range}) {
+        ShardedGraph sharded(graph, 3, partition);
+        EXPECT_EQ(sharded.getTotalEdges(), graph.getTotalEdges());
+
+        sharded.addUndirectedEdge(0, 5, 2);
+        sharded.removeUndirectedEdge(2, 3);
+        Graph expected = graph;
+        expected.addUndirectedEdge(0, 5, 2);
+        expected.removeUndirectedEdge(2, 3);
+
+        Graph gathered = sharded.gather();
+        EXPECT_EQ(gathered.getTotalEdges(), expected.getTotalEdges());
+        EXPECT_EQ(gathered.getLabels(), expected.getLabels());
+        for (const auto& node: expected.nodes) {
+            for (const auto& edge: node->edgeList) {
+                EXPECT_EQ(gathered.getEdgeWeight(node->id, edge.first->id), edge.second);
+            }
+        }
+    }
+}
+
+// Owners relabel their nodes, after an exchange every ghost carries its owner's label
+static int relabelAndExchange(Shard& shard, int numberShards, ShardTransport& transport) {
+    for (const auto& node: shard.graph.nodes) {
+        if (!shard.isGhost(node->id)) {
+            shard.graph.setLabel(node.get(), node->id + 100);
+        }
+    }
+    exchangeGhosts(shard, numberShards, transport);
+
+    int stale = 0;
+    for (int ghostId: shard.ghostIds) {
+        stale += shard.graph.getNode(ghostId)->label != ghostId + 100;
+    }
+    return stale;
+}
+
+TEST(ShardedGraphTest, GhostExchangeAcrossThreadsAndProcesses) {
+    Graph graph = createTwoCommunityGraph();
+    ShardedGraph sharded(graph, 3);
+    size_t ghostCount = 0;
+    for (const auto& shard: sharded.shards) {
+        ghostCount += shard.ghostIds.size();
+    }
+    ASSERT_GT(ghostCount, 0);
+
+    int failures = runShardProcesses(sharded, [&](Shard& shard, ShardTransport& transport) {
+        return relabelAndExchange(shard, sharded.numberShards(), transport);
+    });
+    EXPECT_EQ(failures, 0);
+
+    // A worker failing before the exchange leaves its peers with end of file instead of blocking them
+    failures = runShardProcesses(sharded, [&](Shard& shard, ShardTransport& transport) {
+        if (shard.shardId == 0) {
+            throw runtime_error("worker failed");
+        }
+        return relabelAndExchange(shard, sharded.numberShards(), transport);
+    });
+    EXPECT_GE(failures, 1);
+
+    // Forking next to a running thread is refused
+    promise<void> release;
+    thread running([future = release.get_future()]() { future.wait(); });
+    EXPECT_THROW(runShardProcesses(sharded, [](Shard&, ShardTransport&) { return 0; }), runtime_error);
+    release.set_value();
+    running.join();
+
+    atomic<int> stale = 0;
+    runShardThreads(sharded, [&](Shard& shard, ShardTransport& transport) {
+        stale += relabelAndExchange(shard, sharded.numberShards(), transport);
+    });
+    EXPECT_EQ(stale, 0);
+}
+
+// Degrees add up and every edge is present in both directions with the same weight
+static bool isConsistent(const GraphSnapshot& snapshot) {
+    long long degreeSum = 0;
+    for (int index = 0; index < snapshot.numberNodes(); ++index) {
+        const VersionedNode& node = snapshot.getNodeAt(index);
+        long long weightSum = 0;
+        for (const auto& [destIndex, edgeWeight]: node.edgeList) {
+            weightSum += edgeWeight;
+            const auto& reverse = snapshot.getNodeAt(destIndex).edgeList;
+            auto it = find_if(reverse.begin(), reverse.end(), [index](const pair<int, int>& edge) { return edge.first == index; });
+            if (it == reverse.end() || it->second != edgeWeight) {
+                return false;
+            }
+        }
+        if (weightSum != node.degree) {
+            return false;
+        }
+        degreeSum += weightSum;
+    }
+    return degreeSum == 2 * snapshot.getTotalEdges();
+}
+
+TEST(ConcurrentGraphTest, SnapshotsStayConsistentDuringIngestion) {
+    Graph graph = createTwoCommunityGraph();
+    ConcurrentGraph concurrent(graph, 4);
+    GraphSnapshot initial = concurrent.snapshot();
+
+    atomic<bool> done = false;
+    atomic<int> inconsistent = 0;
+    thread reader([&]() {
+        uint64_t lastEpoch = 0;
+        while (!done) {
+            GraphSnapshot snapshot = concurrent.snapshot();
+            inconsistent += !isConsistent(snapshot) || snapshot.getEpoch() < lastEpoch;
+            lastEpoch = snapshot.getEpoch();
+        }
+    });
+
+    mt19937 gen(7);
+    uniform_int_distribution<int> nodeDistribution(0, 5);
+    for (int i = 0; i < 2000; ++i) {
+        EdgeEvent event{nodeDistribution(gen), nodeDistribution(gen), (i % 3 == 0) ? EdgeOp::Remove : EdgeOp::Add, {}};
+        concurrent.apply(event);
+        if (i == 1000) {
+            concurrent.addNode(6, 1);
+            concurrent.addUndirectedEdge(6, 0);
+        }
+        concurrent.setLabel(nodeDistribution(gen), i);
+        if (i % 10 == 0) {
+            concurrent.publish();
+        }
+    }
+    concurrent.publish();
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(inconsistent, 0);
+    // Old snapshots are untouched by later epochs
+    EXPECT_EQ(initial.getTotalEdges(), graph.getTotalEdges());
+    EXPECT_EQ(initial.getLabels(), graph.getLabels());
+
+    GraphSnapshot latest = concurrent.snapshot();
+    EXPECT_EQ(latest.numberNodes(), 7);
+    Graph materialized = latest.toGraph();
+    EXPECT_EQ(materialized.getTotalEdges(), latest.getTotalEdges());
+    EXPECT_EQ(materialized.getLabels(), latest.getLabels());
+}
+
+TEST(CompressedCsrGraphTest, StreamVByteRoundTrips) {
+    vector<uint32_t> values{0, 3, 3, 300, 70000, 20000000, 4000000000u, 4000000001u, 4000000001u};
+    vector<uint8_t> controls, data;
+    streamVByteEncode(values.data(), values.size(), true, 0, controls, data);
+    data.resize(data.size() + streamVBytePadding);
+
+    for (auto decode: {streamVByteDecode, streamVByteDecodeScalar}) {
+        vector<uint32_t> decoded(values.size());
+        uint32_t previous = 0;
+        decode(controls.data(), data.data(), values.size(), true, previous, decoded.data());
+        EXPECT_EQ(decoded, values);
+        EXPECT_EQ(previous, values.back());
+    }
+}
+
+TEST(CompressedCsrGraphTest, MatchesPlainSnapshot) {
+    mt19937 gen(11);
+    uniform_int_distribution<int> nodeDistribution(0, 299);
+    for (bool weighted: {false, true}) {
+        Graph graph(300);
+        for (int i = 0; i < 300; ++i) {
+            graph.setLabel(i, i % 4);
+        }
+        for (int i = 0; i < 3000; ++i) {
+            int src = nodeDistribution(gen);
+            int dest = nodeDistribution(gen);
+            if (src != dest && graph.getEdgeWeight(src, dest) == 0) {
+                graph.addUndirectedEdge(src, dest, weighted ? 1 + i % 5 : 1);
+            }
+        }
+
+        CsrGraph plain(graph);
+        CompressedCsrGraph compressed(plain);
+        EXPECT_EQ(compressed.hasUnitWeights(), !weighted);
+        EXPECT_EQ(compressed.numberEdgeEntries(), plain.numberEdgeEntries());
+        EXPECT_LT(compressed.adjacencyBytes(), plain.numberEdgeEntries() * 2 * sizeof(int));
+
+        for (int index = 0; index < plain.numberNodes(); ++index) {
+            vector<pair<int, int>> expected, actual;
+            plain.forEachNeighbor(index, [&expected](int neighbor, int weight) { expected.emplace_back(neighbor, weight); });
+            compressed.forEachNeighbor(index, [&actual](int neighbor, int weight) { actual.emplace_back(neighbor, weight); });
+            sort(expected.begin(), expected.end());
+            EXPECT_EQ(actual, expected);
+        }
+        EXPECT_DOUBLE_EQ(modularity(compressed), modularity(plain));
+        EXPECT_DOUBLE_EQ(embeddedness(compressed), embeddedness(plain));
+    }
+}
+
+TEST(SbmTest, FullInstanceMatchesBlockProbabilities) {
+    Sbm sbm(400, 4, 0.5, 0.05);
+    vector<pair<int, int>> edges = sbm.generateAllEdges();
+
+    set<pair<int, int>> distinct;
+    int intraEdges = 0;
+    for (const auto& [src, dest]: edges) {
+        EXPECT_NE(src, dest);
+        EXPECT_TRUE(distinct.insert(minmax(src, dest)).second);
+        intraEdges += sbm.sbm_graph.getNode(src)->label == sbm.sbm_graph.getNode(dest)->label;
+    }
+
+    // Expected 4 * C(100, 2) * 0.5 = 9900 intra and 6 * 100 * 100 * 0.05 = 3000 inter edges, within 5 sigma
+    int interEdges = edges.size() - intraEdges;
+    EXPECT_NEAR(intraEdges, 9900, 5 * sqrt(19800 * 0.5 * 0.5));
+    EXPECT_NEAR(interEdges, 3000, 5 * sqrt(60000 * 0.05 * 0.95));
+
+    // Every node lands in exactly one block
+    for (int label = 0; label < 4; ++label) {
+        EXPECT_EQ(sbm.sbm_graph.getCommunity(label).size(), 100);
+    }
+}
+
+TEST(SbmTest, SeededGenerationIsIndependentOfThreadCount) {
+    // Philox4x32-10 known answer from the Random123 test vectors
+    Philox4x32::Counter block = Philox4x32::generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, 0x299f31d0a4093822ULL);
+    EXPECT_EQ(block, (Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+
+    // Blocks of 6000 nodes span several sampling chunks
+    Sbm first(12000, 2, 0.01, 0.001, 7);
+    Sbm second(12000, 2, 0.01, 0.001, 7);
+    EXPECT_EQ(first.sbm_graph.getLabels(), second.sbm_graph.getLabels());
+
+    vector<pair<int, int>> edges = first.generateAllEdges(1);
+    EXPECT_GT(edges.size(), 0);
+    for (int threadCount: {2, 5}) {
+        EXPECT_EQ(second.generateAllEdges(threadCount), edges);
+    }
+    EXPECT_EQ(first.generateEdge(), second.generateEdge());
+
+    Sbm other(12000, 2, 0.01, 0.001, 8);
+    EXPECT_NE(other.generateAllEdges(2), edges);
+}
+
+TEST(SbmTest, UnevenBlocksAndDegreeCorrection) {
+    AliasTable table({1.0, 0.0, 3.0});
+    mt19937 gen(3);
+    vector<int> draws(3, 0);
+    for (int i = 0; i < 40000; ++i) {
+        draws[table.sample(gen)]++;
+    }
+    EXPECT_EQ(draws[1], 0);
+    EXPECT_NEAR(draws[2] / 40000.0, 0.75, 0.02);
+
+    vector<int> blockSizes = {50, 150, 300};
+    Sbm uneven(blockSizes, 0.3, 0.01, 11);
+    for (int label = 0; label < 3; ++label) {
+        EXPECT_EQ(uneven.sbm_graph.getCommunity(label).size(), blockSizes[label]);
+    }
+    // Intra edges land in blocks by their number of pairs
+    vector<int> intraEdges(3, 0);
+    for (const auto& [src, dest]: uneven.generateAllEdges(1)) {
+        int label = uneven.sbm_graph.getNode(src)->label;
+        if (label == uneven.sbm_graph.getNode(dest)->label) {
+            intraEdges[label]++;
+        }
+    }
+    EXPECT_NEAR(intraEdges[2], 0.3 * 300 * 299 / 2, 5 * sqrt(0.3 * 0.7 * 300 * 299 / 2));
+    EXPECT_NEAR(intraEdges[0], 0.3 * 50 * 49 / 2, 5 * sqrt(0.3 * 0.7 * 50 * 49 / 2));
+
+    // Degrees follow the propensities, the highest propensity node gets far more edges than the median one
+    vector<double> propensities = Sbm::powerLawPropensities(500, 2.2, 5);
+    Sbm corrected(blockSizes, 0.3, 0.01, 5, propensities);
+    EXPECT_TRUE(corrected.isDegreeCorrected());
+    EXPECT_THROW(corrected.generateAllEdges(), runtime_error);
+    vector<int> degrees(500, 0);
+    for (int i = 0; i < 20000; ++i) {
+        auto [src, dest] = corrected.generateEdge();
+        EXPECT_NE(src, dest);
+        degrees[src]++;
+        degrees[dest]++;
+    }
+    int hub = max_element(propensities.begin(), propensities.end()) - propensities.begin();
+    vector<int> sortedDegrees = degrees;
+    sort(sortedDegrees.begin(), sortedDegrees.end());
+    EXPECT_GT(degrees[hub], 10 * sortedDegrees[250]);
+
+    // Pairs come up in proportion to the product of their propensities. With a hub holding half of the weight of a
+    // block, pairs with the hub make up 19 * 19 of the (38 * 38 - 19 * 19 - 19) / 2 pair weight.
+    vector<double> hubPropensities(20, 1.0);
+    hubPropensities[0] = 19.0;
+    Sbm hubBlock(vector<int>{20}, 0.3, 0.01, 13, hubPropensities);
+    int hubPairs = 0;
+    for (int i = 0; i < 40000; ++i) {
+        auto [src, dest] = hubBlock.generateEdge();
+        hubPairs += (src == 0 || dest == 0);
+    }
+    EXPECT_NEAR(hubPairs / 40000.0, 361.0 / 532.0, 0.015);
+
+    vector<int> randomSizes = Sbm::randomBlockSizes(100, 7, 9);
+    EXPECT_EQ(randomSizes.size(), 7);
+    EXPECT_EQ(accumulate(randomSizes.begin(), randomSizes.end(), 0), 100);
+    EXPECT_GE(*min_element(randomSizes.begin(), randomSizes.end()), 1);
+}
+
+// Drains a stream into added and removed edge lists
+static void drainEdgeStream(EdgeStream& stream, vector<pair<int, int>>& addedEdges, vector<pair<int, int>>& removedEdges) {
+    EdgeEvent event;
+    while (stream.next(event)) {
+        (event.op == EdgeOp::Add ? addedEdges : removedEdges).push_back({event.src, event.dest});
+    }
+}
+
+TEST(EdgeStreamTest, SourcesYieldTheSameEvents) {
+    vector<pair<int, int>> expectedAdded{{0, 1}, {1, 2}, {2, 3}};
+    vector<pair<int, int>> expectedRemoved{{1, 2}};
+
+    istringstream text("# comment\n0 1\n+ 1 2\n\n+ 2 3\n- 1 2\n");
+    TextEdgeStream textStream(text);
+    vector<pair<int, int>> addedEdges, removedEdges;
+    drainEdgeStream(textStream, addedEdges, removedEdges);
+    EXPECT_EQ(addedEdges, expectedAdded);
+    EXPECT_EQ(removedEdges, expectedRemoved);
+
+    VectorEdgeStream vectorStream(expectedAdded, expectedRemoved);
+    addedEdges.clear();
+    removedEdges.clear();
+    drainEdgeStream(vectorStream, addedEdges, removedEdges);
+    EXPECT_EQ(addedEdges, expectedAdded);
+    EXPECT_EQ(removedEdges, expectedRemoved);
+
+    string filepath = (filesystem::temp_directory_path() / "sbm_test_stream.bin").string();
+    filesystem::remove(filepath);
+    {
+        EdgeEventWriter writer(filepath);
+        writer.append(expectedAdded, EdgeOp::Add);
+        writer.append(expectedRemoved, EdgeOp::Remove);
+    }
+    unique_ptr<EdgeStream> mappedStream = openEdgeStream(filepath);
+    addedEdges.clear();
+    removedEdges.clear();
+    drainEdgeStream(*mappedStream, addedEdges, removedEdges);
+    EXPECT_EQ(addedEdges, expectedAdded);
+    EXPECT_EQ(removedEdges, expectedRemoved);
+    filesystem::remove(filepath);
+
+    istringstream malformed("0 1\n+ 1\n");
+    TextEdgeStream malformedStream(malformed);
+    EXPECT_THROW(drainEdgeStream(malformedStream, addedEdges, removedEdges), runtime_error);
+
+    // Chunk by chunk streaming reproduces the materialized instance
+    Sbm sbm(12000, 2, 0.01, 0.001, 7);
+    SbmInstanceStream instanceStream(sbm);
+    addedEdges.clear();
+    removedEdges.clear();
+    drainEdgeStream(instanceStream, addedEdges, removedEdges);
+    EXPECT_EQ(addedEdges, sbm.generateAllEdges(2));
+    EXPECT_TRUE(removedEdges.empty());
+}
+
+TEST(WorkloadTest, ChurnWindowAndNodeTurnoverStayConsistent) {
+    Sbm sbm(200, 4, 0.2, 0.02, 11);
+    WorkloadConfig config;
+    config.numberAdditions = 5000;
+    config.windowSize = 1500;
+    config.deleteRate = 0.3;
+    config.departureRate = 0.002;
+    config.arrivalRate = 0.01;
+    config.initialActiveFraction = 0.5;
+    config.seed = 12;
+    WorkloadEdgeStream stream(sbm, config);
+
+    // Replay on the graph, every removal has to hit a present edge
+    Graph graph = sbm.sbm_graph;
+    EdgeEvent event;
+    long long events = 0;
+    while (stream.next(event)) {
+        ASSERT_NE(event.src, event.dest);
+        bool present = graph.getNode(event.src)->findEdge(event.dest) != -1;
+        if (event.op == EdgeOp::Add) {
+            ASSERT_FALSE(present);
+            graph.addUndirectedEdge(event.src, event.dest);
+        } else {
+            ASSERT_TRUE(present);
+            graph.removeUndirectedEdge(event.src, event.dest);
+        }
+        events++;
+    }
+
+    EXPECT_EQ(stream.numberAdditions(), 5000);
+    EXPECT_EQ(stream.numberAdditions() + stream.numberRemovals(), events);
+    EXPECT_EQ(graph.getTotalEdges(), stream.numberLiveEdges());
+    EXPECT_LE(stream.numberLiveEdges(), 1500);
+    EXPECT_GT(stream.numberRemovals(), 0.3 * events);
+    EXPECT_GT(stream.numberActiveNodes(), 100);
+
+    WorkloadConfig invalid;
+    invalid.deleteRate = 1.0;
+    EXPECT_THROW(WorkloadEdgeStream(sbm, invalid), invalid_argument);
+}
+
+TEST(EvolvingSbmTest, PlantedChangesFollowTheSchedule) {
+    Sbm sbm(120, 3, 0.3, 0.02, 5);
+    WorkloadConfig workload;
+    workload.numberAdditions = 1500;
+    workload.windowSize = 400;
+    workload.seed = 6;
+    EvolutionConfig evolution;
+    evolution.changes = {
+        {CommunityChange::Split, 600, 0, 0},
+        {CommunityChange::Merge, 300, 0, 1, 0},
+        {CommunityChange::Migrate, 900, 10},
+        {CommunityChange::Drift, 1000, 0, -1, -1, 0.05, 0.05, 200},
+    };
+    evolution.checkpointInterval = 500;
+    evolution.checkpointPath = (filesystem::temp_directory_path() / "sbm_test_checkpoints.bin").string();
+    EvolvingSbmStream stream(sbm, workload, evolution);
+
+    vector<vector<pair<int, int>>> addedBetweenChanges(2);
+    EdgeEvent event;
+    while (stream.next(event)) {
+        long long additions = stream.numberAdditions();
+        if (event.op == EdgeOp::Add && additions <= 300) {
+            addedBetweenChanges[0].push_back({event.src, event.dest});
+        } else if (event.op == EdgeOp::Add && additions > 300 && additions <= 600) {
+            addedBetweenChanges[1].push_back({event.src, event.dest});
+        }
+    }
+    EXPECT_DOUBLE_EQ(stream.currentIntraCommunityEdgeProbability(), 0.05);
+
+    vector<pair<long long, vector<int>>> checkpoints = readPartitionCheckpoints(evolution.checkpointPath);
+    filesystem::remove(evolution.checkpointPath);
+    // Start, merge, split, periodic, migration and drift
+    ASSERT_GE(checkpoints.size(), 6);
+    EXPECT_EQ(checkpoints.front().first, 0);
+    EXPECT_EQ(checkpoints.back().second, stream.currentPartition());
+
+    auto countCommunities = [](const vector<int>& partition) {
+        return set<int>(partition.begin(), partition.end()).size();
+    };
+    auto intraFraction = [](const vector<pair<int, int>>& edges, const vector<int>& partition) {
+        long long intra = count_if(edges.begin(), edges.end(), [&](const pair<int, int>& edge) {
+            return partition[edge.first] == partition[edge.second];
+        });
+        return double(intra) / edges.size();
+    };
+    // Periodic checkpoints repeat the partition, the next different one is the following change
+    const vector<int>& initial = checkpoints[0].second;
+    const vector<int>& merged = checkpoints[1].second;
+    auto splitCheckpoint = find_if(checkpoints.begin() + 2, checkpoints.end(), [&](const auto& checkpoint) {
+        return checkpoint.second != merged;
+    });
+    ASSERT_NE(splitCheckpoint, checkpoints.end());
+    const vector<int>& split = splitCheckpoint->second;
+    EXPECT_EQ(countCommunities(initial), 3);
+    for (int nodeId = 0; nodeId < 120; ++nodeId) {
+        EXPECT_EQ(initial[nodeId], sbm.sbm_graph.getNode(nodeId)->label);
+        // Block 1 went into block 0
+        EXPECT_EQ(merged[nodeId], (initial[nodeId] == 1) ? 0 : initial[nodeId]);
+    }
+    EXPECT_EQ(countCommunities(merged), 2);
+    EXPECT_EQ(countCommunities(split), 3);
+    EXPECT_GT(intraFraction(addedBetweenChanges[0], initial), 0.8);
+    EXPECT_GT(intraFraction(addedBetweenChanges[1], merged), 0.85);
+    // Edges of the merged phase cross the old boundary, unlike the planted structure before it
+    EXPECT_LT(intraFraction(addedBetweenChanges[1], initial), 0.7);
+}
+
+TEST(EvolvingSbmTest, BadSchedulesFailAtConstruction) {
+    Sbm sbm(60, 3, 0.3, 0.02, 5);
+    WorkloadConfig workload;
+    workload.numberAdditions = 100;
+    EvolutionConfig evolution;
+    // Community 1 is gone after the merge
+    evolution.changes = {{CommunityChange::Merge, 10, 0, 1, 0}, {CommunityChange::Split, 50, 0, 1}};
+    EXPECT_THROW(EvolvingSbmStream(sbm, workload, evolution), out_of_range);
+    evolution.changes = {{CommunityChange::Merge, 10, 0, 2, 2}};
+    EXPECT_THROW(EvolvingSbmStream(sbm, workload, evolution), invalid_argument);
+    // The split creates community 3, which can then be merged
+    evolution.changes = {{CommunityChange::Split, 10, 0, 2}, {CommunityChange::Merge, 20, 0, 3, 0}};
+    EXPECT_NO_THROW(EvolvingSbmStream(sbm, workload, evolution));
+}
+
+TEST(MessageKernelTest, VectorKernelsMatchScalar) {
+    mt19937 gen(17);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int count: {1, 3, 4, 5, 8, 10, 17, 64}) {
+        // Six messages, folded in a shuffled order with one left out
+        vector<double> messages(6 * count), prior(count), start(count);
+        for (double& value: messages) {
+            value = unit(gen);
+        }
+        for (int s = 0; s < count; ++s) {
+            prior[s] = unit(gen);
+            start[s] = unit(gen);
+        }
+        vector<int> edgeIds{4, 0, 5, 2, 1};
+
+        vector<double> expected = start;
+        multiplyMessages(MessageKernel::Scalar, expected.data(), messages.data(), edgeIds.data(), edgeIds.size(), prior.data(), count, 0.01, 0.8);
+        vector<double> product = expected;
+        normalizeMessage(MessageKernel::Scalar, expected.data(), count);
+        for (MessageKernel kernel: {MessageKernel::Avx2, MessageKernel::Avx512}) {
+            if (!messageKernelSupported(kernel)) {
+                continue;
+            }
+            // A guard value past the end catches stores outside the message
+            vector<double> result = start;
+            result.push_back(-1.0);
+            multiplyMessages(kernel, result.data(), messages.data(), edgeIds.data(), edgeIds.size(), prior.data(), count, 0.01, 0.8);
+            EXPECT_TRUE(equal(product.begin(), product.end(), result.begin())) << messageKernelName(kernel) << " k=" << count;
+            normalizeMessage(kernel, result.data(), count);
+            EXPECT_EQ(result.back(), -1.0) << messageKernelName(kernel);
+            for (int s = 0; s < count; ++s) {
+                EXPECT_NEAR(result[s], expected[s], 1e-12) << messageKernelName(kernel) << " k=" << count;
+            }
+        }
+    }
+
+    vector<double> zeros(5, 0.0);
+    normalizeMessage(bestMessageKernel(), zeros.data(), 5);
+    EXPECT_EQ(zeros, vector<double>(5, 0.0));
+}
+
+TEST(MessageKernelTest, RescaledProductSurvivesHubs) {
+    mt19937 gen(23);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<MessageKernel> kernels;
+    for (MessageKernel kernel: {MessageKernel::Scalar, MessageKernel::Avx2, MessageKernel::Avx512}) {
+        if (messageKernelSupported(kernel)) {
+            kernels.push_back(kernel);
+        }
+    }
+
+    for (int count: {3, 4, 10, 17}) {
+        // A hub with 3000 neighbors, far past the point where the plain product underflows
+        int degree = 3000;
+        vector<double> messages(size_t(degree) * count), prior(count);
+        for (double& value: messages) {
+            value = unit(gen);
+        }
+        for (int s = 0; s < count; ++s) {
+            prior[s] = 0.2 + unit(gen);
+        }
+        prior[0] = 0.0;
+        vector<int> edgeIds(degree);
+        iota(edgeIds.begin(), edgeIds.end(), 0);
+        size_t interval = messageRescaleInterval(prior.data(), count, 0.01, 0.8);
+
+        // Log domain reference
+        vector<double> logs(count, 0.0), expected(count, 0.0);
+        for (int edgeId: edgeIds) {
+            for (int s = 1; s < count; ++s) {
+                logs[s] += log((0.01 + 0.8 * messages[size_t(edgeId) * count + s]) * prior[s]);
+            }
+        }
+        double largest = *max_element(logs.begin() + 1, logs.end());
+        double Z = 0;
+        for (int s = 1; s < count; ++s) {
+            expected[s] = exp(logs[s] - largest);
+            Z += expected[s];
+        }
+        for (double& value: expected) {
+            value /= Z;
+        }
+
+        for (MessageKernel kernel: kernels) {
+            vector<double> product(count, 1.0);
+            multiplyMessages(kernel, product.data(), messages.data(), edgeIds.data(), degree, prior.data(), count, 0.01, 0.8);
+            EXPECT_EQ(product, vector<double>(count, 0.0)) << messageKernelName(kernel);
+
+            // Folded in two runs like StreamBP does around an excluded slot, the exponents carry over
+            vector<double> result(count, 1.0);
+            vector<int64_t> exponents(count, 0);
+            multiplyMessagesRescaled(kernel, result.data(), exponents.data(), messages.data(), edgeIds.data(), 1200, prior.data(), count, 0.01, 0.8, interval);
+            multiplyMessagesRescaled(kernel, result.data(), exponents.data(), messages.data(), edgeIds.data() + 1200, degree - 1200, prior.data(), count, 0.01, 0.8, interval);
+            normalizeRescaledMessage(kernel, result.data(), exponents.data(), count);
+            EXPECT_EQ(exponents, vector<int64_t>(count, 0));
+            for (int s = 0; s < count; ++s) {
+                EXPECT_NEAR(result[s], expected[s], 1e-9) << messageKernelName(kernel) << " k=" << count;
+            }
+        }
+
+        // Without underflow both modes give the same message
+        for (MessageKernel kernel: kernels) {
+            vector<double> product(count, 1.0), result(count, 1.0);
+            vector<int64_t> exponents(count, 0);
+            multiplyMessages(kernel, product.data(), messages.data(), edgeIds.data(), 40, prior.data(), count, 0.01, 0.8);
+            normalizeMessage(kernel, product.data(), count);
+            multiplyMessagesRescaled(kernel, result.data(), exponents.data(), messages.data(), edgeIds.data(), 40, prior.data(), count, 0.01, 0.8, interval);
+            normalizeRescaledMessage(kernel, result.data(), exponents.data(), count);
+            EXPECT_EQ(result, product) << messageKernelName(kernel) << " k=" << count;
+        }
+    }
+}
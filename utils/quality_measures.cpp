@@ -1,8 +1,13 @@
 #include "quality_measures.h"
 
-double modularity(const Graph& graph, int totalEdges) {
+double modularity(const Graph& graph, long long totalEdges) {
+    return modularity(CsrGraph(graph), totalEdges);
+}
+
+// Modularity over any snapshot with dense indices and forEachNeighbor
+template <typename Snapshot>
+double snapshotModularity(const Snapshot& graph, long long totalEdges) {
     if (totalEdges == -1) {
-        cerr << "Calculating total edges, please see if this can be computed in the beginning and passed as a parameter." << endl;
         totalEdges = graph.getTotalEdges();
     }
 
@@ -12,34 +17,27 @@ double modularity(const Graph& graph, int totalEdges) {
     }
 
     double q = 0.0;
-    unordered_map<int, int> degrees{};
-
-    // Degree counts weight on edge as well
-    for (const auto& node: graph.nodes) {
-        int degreeWeight = 0;
-        for (const auto& edge: node->edgeList) {
-            degreeWeight += edge.second;
-        }
-        degrees.emplace(node->id, degreeWeight);
-    }
-
-    for (const auto& srcNode: graph.nodes) {
-        for (const auto& edge: srcNode->edgeList) {
-            const Node* destNode = edge.first;
-            int weight = edge.second;
-            try {
-                if (srcNode->label == destNode->label) {
-                    q += (weight - static_cast<double>(degrees.at(srcNode->id) * degrees.at(destNode->id)) / (2.0 * totalEdges));
-                }
-            } catch (const out_of_range& e) {
-                throw out_of_range("Node " + to_string(srcNode->id) + " or " + to_string(destNode->id) + " not found.");
+    for (int src = 0; src < graph.numberNodes(); ++src) {
+        int srcLabel = graph.getLabel(src);
+        double srcDegree = static_cast<double>(graph.getDegree(src));
+        graph.forEachNeighbor(src, [&](int dest, int weight) {
+            if (srcLabel == graph.getLabel(dest)) {
+                q += (weight - srcDegree * graph.getDegree(dest) / (2.0 * totalEdges));
             }
-        }
+        });
     }
 
     return q / (2.0 * totalEdges);
 }
 
+double modularity(const CsrGraph& graph, long long totalEdges) {
+    return snapshotModularity(graph, totalEdges);
+}
+
+double modularity(const CompressedCsrGraph& graph, long long totalEdges) {
+    return snapshotModularity(graph, totalEdges);
+}
+
 int getSetDiff(set<int> predicted, set<int> original) {
     int diff_count = 0;
     for (const int & element: predicted) {
@@ -315,23 +313,36 @@ double loglikelihood(const Graph& graph, const Graph& edgeGraph) {
 }
 
 double embeddedness(const Graph& graph) {
-    int withinCommunityNodes;
+    return embeddedness(CsrGraph(graph));
+}
+
+template <typename Snapshot>
+double snapshotEmbeddedness(const Snapshot& graph) {
     double total_embeddedness = 0.0;
-    for (const auto& node: graph.nodes) {
-        withinCommunityNodes = 0;
-        for (const auto& edge: node->edgeList) {
-            const Node* neighbor = edge.first;
-            if (node->label == neighbor->label) {
+    for (int node = 0; node < graph.numberNodes(); ++node) {
+        int withinCommunityNodes = 0;
+        int neighborCount = 0;
+        graph.forEachNeighbor(node, [&](int neighbor, int) {
+            if (graph.getLabel(node) == graph.getLabel(neighbor)) {
                 withinCommunityNodes++;
             }
-        }
-        if (node->edgeList.size() > 0) {
-            total_embeddedness += static_cast<double>(withinCommunityNodes) / node->edgeList.size();
+            neighborCount++;
+        });
+        if (neighborCount > 0) {
+            total_embeddedness += static_cast<double>(withinCommunityNodes) / neighborCount;
         }
     }
     return total_embeddedness;
 }
 
+double embeddedness(const CsrGraph& graph) {
+    return snapshotEmbeddedness(graph);
+}
+
+double embeddedness(const CompressedCsrGraph& graph) {
+    return snapshotEmbeddedness(graph);
+}
+
 double nodeOverlapAccuracy(const Graph& graph, vector<set<int>> original_partition, ofstream& outfile, string title) {
     int correct_count = 0;
     unordered_map<int, set<int>> predicted_labels = graph.getCommunities();
@@ -398,7 +409,7 @@ double nodeOverlapAccuracy(const Graph& graph, vector<set<int>> original_partiti
     return static_cast<double>(correct_count) / graph.nodes.size();
 }
 
-double edgeClassificationAccuracy(Graph& predicted_graph, Graph& original_graph) {
+double edgeClassificationAccuracy(const Graph& predicted_graph, const Graph& original_graph) {
     int weighted_correct_count = 0;
     for (const auto& node: predicted_graph.nodes) {
         for (const auto& edge: node->edgeList) {
@@ -413,29 +424,38 @@ double edgeClassificationAccuracy(Graph& predicted_graph, Graph& original_graph)
     return static_cast<double>(weighted_correct_count) / (2.0 * predicted_graph.getTotalEdges());
 }
 
-double maximalMatchingAccuracy(Graph& predicted_graph, Graph& original_graph, ofstream& outfile, string title) {
-    vector<vector<int>> cost_matrix;
-    vector<set<int>> original_partition, predicted_partition;
-    for (const auto& pair: predicted_graph.getCommunities()) {
-        predicted_partition.push_back(pair.second);
-    }
-    for (const auto& pair: original_graph.getCommunities()) {
-        original_partition.push_back(pair.second);
+namespace {
+    // Sorted member ids of every community, with the position of each label in the returned partition
+    vector<vector<int>> getSortedPartition(const Graph& graph, unordered_map<int, size_t>& label_positions) {
+        vector<vector<int>> partition;
+        partition.reserve(graph.numberCommunities());
+        for (const auto& [label, members]: graph.getCommunityMembers()) {
+            label_positions.emplace(label, partition.size());
+            vector<int>& member_ids = partition.emplace_back();
+            member_ids.reserve(members.size());
+            for (const Node* node: members) {
+                member_ids.push_back(node->id);
+            }
+            sort(member_ids.begin(), member_ids.end());
+        }
+        return partition;
     }
+}
+
+double maximalMatchingAccuracy(const Graph& predicted_graph, const Graph& original_graph, ofstream& outfile, string title) {
+    unordered_map<int, size_t> original_positions, predicted_positions;
+    vector<vector<int>> original_partition = getSortedPartition(original_graph, original_positions);
+    vector<vector<int>> predicted_partition = getSortedPartition(predicted_graph, predicted_positions);
 
-    // Calculate cost matrix
-    for (const auto& row_comm: original_partition) {
-        vector<int> row_cost;
-        for (const auto& col_comm: predicted_partition) {
-            vector<int> intersection;
-            set_intersection(
-                row_comm.begin(), row_comm.end(),
-                col_comm.begin(), col_comm.end(),
-                back_inserter(intersection)
-            );
-            row_cost.push_back(intersection.size());
+    // Cost matrix holds community intersection sizes, counted in one pass over the predicted nodes
+    vector<vector<int>> cost_matrix(original_partition.size(), vector<int>(predicted_partition.size(), 0));
+    for (const auto& node: predicted_graph.nodes) {
+        auto it = original_graph.id_to_index_mapping.find(node->id);
+        if (it == original_graph.id_to_index_mapping.end()) {
+            continue;
         }
-        cost_matrix.push_back(row_cost);
+        int original_label = original_graph.nodes[it->second]->label;
+        cost_matrix[original_positions.at(original_label)][predicted_positions.at(node->label)]++;
     }
 
     vector<int> assignment;
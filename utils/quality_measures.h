@@ -2,6 +2,8 @@
 #define QUALITY_MEASURES_H
 
 #include "src/graph.h"
+#include "src/csr_graph.h"
+#include "src/compressed_csr_graph.h"
 #include <set>
 #include <queue>
 #include <limits>
@@ -15,18 +17,22 @@
 
 using namespace std;
 
-double modularity(const Graph& graph, int totalEdges = -1);
+double modularity(const Graph& graph, long long totalEdges = -1);
+double modularity(const CsrGraph& graph, long long totalEdges = -1);
+double modularity(const CompressedCsrGraph& graph, long long totalEdges = -1);
 double symmetricDifference(const Graph& graph, unordered_map<int, set<int>> original_labels);
 long getRAMUsage();
 double f1Score(const Graph& graph, unordered_map<int, int> original_labels);
 // edgeGraph used for original graph as we dont keep edge information on this graph
 double loglikelihood(const Graph& graph, const Graph& edgeGraph);
 double embeddedness(const Graph& graph);
+double embeddedness(const CsrGraph& graph);
+double embeddedness(const CompressedCsrGraph& graph);
 bool get_cpu_times(size_t &idle_time, size_t &total_time);
 vector<size_t> get_cpu_times();
 double nodeOverlapAccuracy(const Graph& graph, vector<set<int>> original_partition, ofstream& outfile, string title = "");
 double maxJaccardSum(const Graph& graph, vector<set<int>> original_partition, ofstream& outfile, string title = "Predicted");
-double edgeClassificationAccuracy(Graph& predicted_graph, Graph& original_graph);
-double maximalMatchingAccuracy(Graph& predicted_graph, Graph& original_graph, ofstream& outfile, string title = "Predicted");
+double edgeClassificationAccuracy(const Graph& predicted_graph, const Graph& original_graph);
+double maximalMatchingAccuracy(const Graph& predicted_graph, const Graph& original_graph, ofstream& outfile, string title = "Predicted");
 
 #endif // QUALITY_MEASURES_H
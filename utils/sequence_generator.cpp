@@ -2,11 +2,20 @@
 
 using namespace std;
 
-generated_sequence generateSequence(string filename) {
+generated_sequence generateSequence(string filename, bool materializeEdges) {
     // Required Parameters
     int nodes, edges, communities, radius, algorithm_number;
     double intra_community_edge_probability, inter_community_edge_probability;
     bool uneven_node_distribution;
+    bool full_instance = false;
+    uint64_t seed = random_device{}();
+    vector<int> block_sizes;
+    double degree_exponent = 0.0;
+    NodeOrder node_order = NodeOrder::None;
+    MessageScaling message_scaling = MessageScaling::Product;
+    WorkloadConfig workload;
+    EvolutionConfig evolution;
+    string checkpoint_file = "";
 
     string configPath = CONFIG_DIRECTORY + filename;
 
@@ -56,19 +65,130 @@ generated_sequence generateSequence(string filename) {
     if (jsonData.contains("uneven_node_distribution")) {
         uneven_node_distribution = jsonData["uneven_node_distribution"].get<bool>();
     }
+    if (jsonData.contains("full_instance")) {
+        full_instance = jsonData["full_instance"].get<bool>();
+    }
+    if (jsonData.contains("block_sizes")) {
+        block_sizes = jsonData["block_sizes"].get<vector<int>>();
+    }
+    if (jsonData.contains("degree_exponent")) {
+        degree_exponent = jsonData["degree_exponent"].get<double>();
+    }
+    if (jsonData.contains("seed")) {
+        seed = jsonData["seed"].get<uint64_t>();
+    }
+    if (jsonData.contains("window_size")) {
+        workload.windowSize = jsonData["window_size"].get<long long>();
+    }
+    if (jsonData.contains("delete_rate")) {
+        workload.deleteRate = jsonData["delete_rate"].get<double>();
+    }
+    if (jsonData.contains("node_arrival_rate")) {
+        workload.arrivalRate = jsonData["node_arrival_rate"].get<double>();
+    }
+    if (jsonData.contains("node_departure_rate")) {
+        workload.departureRate = jsonData["node_departure_rate"].get<double>();
+    }
+    if (jsonData.contains("initial_active_fraction")) {
+        workload.initialActiveFraction = jsonData["initial_active_fraction"].get<double>();
+    }
+    if (jsonData.contains("planted_changes")) {
+        for (const auto& entry: jsonData["planted_changes"]) {
+            PlantedChange change;
+            string type = entry["type"].get<string>();
+            if (type == "migrate") {
+                change.type = CommunityChange::Migrate;
+            } else if (type == "merge") {
+                change.type = CommunityChange::Merge;
+            } else if (type == "split") {
+                change.type = CommunityChange::Split;
+            } else if (type == "drift") {
+                change.type = CommunityChange::Drift;
+            } else {
+                throw runtime_error("Unknown planted change " + type + ", expected migrate, merge, split or drift");
+            }
+            change.at = entry.value("at", 0LL);
+            change.count = entry.value("count", 0);
+            change.community = entry.value("community", -1);
+            change.target = entry.value("target", -1);
+            change.intraCommunityEdgeProbability = entry.value("intra_community_edge_probability", 0.0);
+            change.interCommunityEdgeProbability = entry.value("inter_community_edge_probability", 0.0);
+            change.duration = entry.value("duration", 0LL);
+            evolution.changes.push_back(change);
+        }
+    }
+    if (jsonData.contains("checkpoint_interval")) {
+        evolution.checkpointInterval = jsonData["checkpoint_interval"].get<long long>();
+    }
+    if (jsonData.contains("checkpoint_file")) {
+        checkpoint_file = jsonData["checkpoint_file"].get<string>();
+    }
+    if (jsonData.contains("node_order")) {
+        string node_order_name = jsonData["node_order"].get<string>();
+        if (node_order_name == "degree") {
+            node_order = NodeOrder::Degree;
+        } else if (node_order_name == "rcm") {
+            node_order = NodeOrder::ReverseCuthillMcKee;
+        } else if (node_order_name == "community") {
+            node_order = NodeOrder::Community;
+        } else if (node_order_name != "none") {
+            throw runtime_error("Unknown node order " + node_order_name + ", expected none, degree, rcm or community");
+        }
+    }
+    if (jsonData.contains("message_scaling")) {
+        string message_scaling_name = jsonData["message_scaling"].get<string>();
+        if (message_scaling_name == "rescaled") {
+            message_scaling = MessageScaling::Rescaled;
+        } else if (message_scaling_name != "product") {
+            throw runtime_error("Unknown message scaling " + message_scaling_name + ", expected product or rescaled");
+        }
+    }
+
+    // Explicit block sizes take precedence, otherwise uneven distributions cut the nodes at random points
+    if (!block_sizes.empty()) {
+        nodes = accumulate(block_sizes.begin(), block_sizes.end(), 0);
+        communities = block_sizes.size();
+    } else if (uneven_node_distribution) {
+        block_sizes = Sbm::randomBlockSizes(nodes, communities, seed);
+    } else if (nodes % communities != 0) {
+        // Make sure nodes can be equally divided into given communities
+        throw runtime_error("Nodes cannot be equally divided in given number of communities");
+    } else {
+        block_sizes.assign(communities, nodes / communities);
+    }
+
+    workload.numberAdditions = edges;
+    // Separate stream from the one the Sbm draws with, same seed still gives the same run
+    workload.seed = seed + 1;
+    if (full_instance && !(workload.isStatic() && evolution.changes.empty() && checkpoint_file.empty())) {
+        throw runtime_error("A full instance is added as is, window, churn and planted changes need full_instance false");
+    }
 
     cout << "Using following parameters for this run:" << endl;
     cout << "Number of nodes: " << nodes << endl;
     cout << "Number of edges: " << edges << endl;
     cout << "Number of communities: " << communities << endl;
     cout << "Uneven distribution of nodes among communities: " << uneven_node_distribution << endl;
+    cout << "Seed: " << seed << endl;
     cout << "Algorithm used: " << (algorithm_number == 1 ? "Dynamic Community Detection"
                                     : (algorithm_number == 2 ? "Belief Propagation"
                                     : (algorithm_number == 3 ? "Approximate Community Detection"
                                     : (algorithm_number == 4 ? "ILP Solver"
                                     : "Unknown Algorithm"))))
                                 << endl;
-    cout << "For now we add edges randomly." << endl;
+    if (full_instance) {
+        cout << "Adding every edge of a full SBM instance, the number of edges is ignored." << endl;
+    } else if (workload.isStatic() && evolution.changes.empty()) {
+        cout << "For now we add edges randomly." << endl;
+    } else {
+        cout << "Dynamic workload, edges are added randomly and removed through:" << endl;
+        cout << "Sliding window of additions: " << workload.windowSize << endl;
+        cout << "Delete rate: " << workload.deleteRate << endl;
+        cout << "Node arrival rate: " << workload.arrivalRate << endl;
+        cout << "Node departure rate: " << workload.departureRate << endl;
+        cout << "Initially active nodes: " << workload.initialActiveFraction << endl;
+        cout << "Planted community changes: " << evolution.changes.size() << endl;
+    }
     if (algorithm_number == 1) {
         // Unique algorithm 1 params
     }
@@ -78,9 +198,8 @@ generated_sequence generateSequence(string filename) {
         cout << "Inter community edge probability: " << inter_community_edge_probability << endl;
     }
 
-    // Make sure nodes can be equally divided into given communities
-    if (!uneven_node_distribution && nodes % communities != 0) {
-        throw runtime_error("Nodes cannot be equally divided in given number of communities");
+    if (degree_exponent > 0.0) {
+        cout << "Degree corrected with propensity exponent: " << degree_exponent << endl;
     }
 
     // Create directory for results
@@ -90,24 +209,43 @@ generated_sequence generateSequence(string filename) {
     if (!filesystem::exists(TEST_OUTPUT_DIRECTORY + resultDirectory)) {
         filesystem::create_directories(TEST_OUTPUT_DIRECTORY + resultDirectory);
     }
+    if (!checkpoint_file.empty()) {
+        evolution.checkpointPath = TEST_OUTPUT_DIRECTORY + resultDirectory + string("/") + checkpoint_file;
+        cout << "Ground truth checkpoints: " << evolution.checkpointPath << endl;
+    }
 
-    Sbm sbm(nodes, communities, intra_community_edge_probability, inter_community_edge_probability);
+    vector<double> propensities = (degree_exponent > 0.0) ? Sbm::powerLawPropensities(nodes, degree_exponent, seed) : vector<double>{};
+    Sbm sbm(block_sizes, intra_community_edge_probability, inter_community_edge_probability, seed, propensities);
     sbm.sbm_graph.draw(TEST_OUTPUT_DIRECTORY + string("/original_graph.png"));
 
     vector<pair<int, int>> addedEdges{};
-    for (int i = 0; i < edges; ++i) {
-        addedEdges.push_back(sbm.generateEdge());
+    vector<pair<int, int>> removedEdges{};
+    if (!materializeEdges) {
+        // Edges are streamed by the caller
+    } else if (full_instance) {
+        addedEdges = sbm.generateAllEdges();
+    } else if (workload.isStatic() && evolution.isStatic()) {
+        addedEdges.reserve(edges);
+        for (int i = 0; i < edges; ++i) {
+            addedEdges.push_back(sbm.generateEdge());
+        }
+    } else {
+        // Replaying the lists applies all additions before any removal, which loses re-added edges and the window
+        throw runtime_error("Churn and evolving workloads can't be materialized into edge lists, stream them instead");
     }
 
-    // TODO: Edge removal is still used for algo testing purposes
-    vector<pair<int, int>> removedEdges = {};
-
     return generated_sequence{
         .sbm = move(sbm),
         .algorithm_number = algorithm_number,
         .radius = radius,
-        .addedEdges = addedEdges,
-        .removedEdges = removedEdges,
-        .resultDirectory = resultDirectory
+        .addedEdges = move(addedEdges),
+        .removedEdges = move(removedEdges),
+        .numberEdges = edges,
+        .fullInstance = full_instance,
+        .workload = workload,
+        .evolution = evolution,
+        .resultDirectory = resultDirectory,
+        .nodeOrder = node_order,
+        .messageScaling = message_scaling
     };
 }
@@ -5,7 +5,11 @@
 #include <fstream>
 #include "nlohmann/json.hpp"
 #include "src/sbm.h"
+#include "src/dynamic_workload.h"
+#include "src/evolving_sbm.h"
+#include "src/message_kernel.h"
 #include <filesystem>
+#include <numeric>
 
 using namespace std;
 
@@ -15,9 +19,17 @@ struct generated_sequence {
     int radius;
     vector<pair<int, int>> addedEdges;
     vector<pair<int, int>> removedEdges;
+    long long numberEdges;
+    bool fullInstance;
+    WorkloadConfig workload;
+    EvolutionConfig evolution;
     string resultDirectory;
+    NodeOrder nodeOrder;
+    MessageScaling messageScaling;
 };
 
-generated_sequence generateSequence(string filename = "default.json");
+// With materializeEdges false the edge lists stay empty and the caller streams the edges from sbm instead. Churn and
+// evolving workloads interleave additions and removals, so they can only be streamed.
+generated_sequence generateSequence(string filename = "default.json", bool materializeEdges = true);
 
 #endif // SEQUENCE_GENERATOR_H